@@ -0,0 +1,66 @@
+#ifndef backend_h
+#define backend_h
+
+#include "http_pool.h"
+#include "unix_pool.h"
+
+//! The backend dialogs are sent to, over the transport its URL names
+
+namespace gateway
+{
+   /// @brief gateway.client.url picks the transport: http://host:port/ for HTTP, unix:/path/to/socket
+   /// (or unix:///path/to/socket) for length-prefixed frames on a Unix socket, see unix_pool.h.
+   /// Both take the same requests and run the same callbacks, on their own loops.
+   struct backend_t
+   {
+      enum class transport_t { http, unix_socket };
+
+      void start(const string& url, size_t nconns, size_t nloops)
+      {
+         string_view_t u(url);
+         if (u.substr(0, 5) == "unix:")
+         {
+            u.remove_prefix(5);
+            if (u.substr(0, 2) == "//")
+               u.remove_prefix(2);
+
+            transport = transport_t::unix_socket;
+            unix_socket.max_outstanding = max_outstanding;
+            unix_socket.idle_timeout    = idle_timeout;
+            unix_socket.timeout         = timeout;
+            unix_socket.start(string(u), nconns, nloops);
+         }
+         else
+         {
+            transport = transport_t::http;
+            http.max_outstanding = max_outstanding;
+            http.idle_timeout    = idle_timeout;
+            http.timeout         = timeout;
+            http.start(url, nconns, nloops);
+         }
+      }
+
+      /// @cb runs on the loop of the connection @req went out on
+      void send(const drogon::HttpRequestPtr& req, drogon::HttpReqCallback cb)
+      {
+         if (transport == transport_t::unix_socket)
+            unix_socket.send(req, std::move(cb));
+         else
+            http.send(req, std::move(cb));
+      }
+
+      size_t outstanding() const { return transport == transport_t::unix_socket ? unix_socket.outstanding() : http.outstanding(); }
+      size_t size() const        { return transport == transport_t::unix_socket ? unix_socket.size() : http.size(); }
+
+      uint32_t    max_outstanding = 64;
+      double      idle_timeout    = 60;  ///< seconds
+      double      timeout         = 5;   ///< seconds per request
+      transport_t transport       = transport_t::http;
+
+   private:
+      http_pool_t http;
+      unix_pool_t unix_socket;
+   };
+}
+
+#endif//backend_h
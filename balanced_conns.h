@@ -0,0 +1,116 @@
+#ifndef balanced_conns_h
+#define balanced_conns_h
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <trantor/net/EventLoopThreadPool.h>
+
+//! How a backend pool picks the connection a request goes out on, shared by every transport
+
+namespace gateway
+{
+   /// @brief The load of one backend connection, a pool's conn_t derives from it
+   struct conn_load_t
+   {
+      using clock_t = std::chrono::steady_clock;
+
+      trantor::EventLoop*   loop = nullptr;
+      std::atomic<uint32_t> outstanding {0};
+      std::atomic<int64_t>  last_used   {0};   ///< clock_t ticks
+
+      void touch() { last_used.store(clock_t::now().time_since_epoch().count(), std::memory_order_relaxed); }
+
+      /// Nothing outstanding and unused for @seconds
+      bool idle_for(double seconds) const
+      {
+         auto idle = clock_t::now() - clock_t::time_point(clock_t::duration(last_used.load(std::memory_order_relaxed)));
+         return !outstanding.load(std::memory_order_relaxed) and idle >= std::chrono::duration<double>(seconds);
+      }
+   };
+
+   /// @brief A pool's connections: requests go to the one with the fewest outstanding, each takes
+   /// at most a given number. Picking and accounting are lock free, any thread can send.
+   template <class conn_t>
+   struct balanced_conns_t
+   {
+      /// Makes @n connections (at least one) spread over @loops. @check_idle(conn) runs on each
+      /// connection's loop every @idle_timeout / 2 seconds to drop it once it sat idle.
+      void start(size_t n, trantor::EventLoopThreadPool& loops, double idle_timeout, auto check_idle)
+      {
+         conns.clear();
+         for (size_t i = 0; i < std::max<size_t>(n, 1); ++i)
+         {
+            auto c  = std::make_unique<conn_t>();
+            c->loop = loops.getNextLoop();
+            c->touch();
+            conns.emplace_back(std::move(c));
+         }
+
+         for (auto& c : conns)
+         {
+            conn_t* cp = c.get();
+            cp->loop->runEvery(std::max(idle_timeout / 2, 1.0), [check_idle, cp] { check_idle(*cp); });
+         }
+      }
+
+      /// The least loaded connection with a slot taken on it, nullptr when all are at @max_outstanding
+      conn_t* acquire(uint32_t max_outstanding)
+      {
+         conn_t* c = least_outstanding();
+         if (c->outstanding.fetch_add(1, std::memory_order_relaxed) >= max_outstanding)
+         {
+            c->outstanding.fetch_sub(1, std::memory_order_relaxed);
+            return nullptr;
+         }
+         c->touch();
+         return c;
+      }
+
+      /// Gives back the slot acquire() took, once the request is answered or failed
+      static void release(conn_t& c)
+      {
+         c.outstanding.fetch_sub(1, std::memory_order_relaxed);
+         c.touch();
+      }
+
+      size_t outstanding() const
+      {
+         size_t n = 0;
+         for (auto& c : conns)
+            n += c->outstanding.load(std::memory_order_relaxed);
+         return n;
+      }
+
+      size_t size() const { return conns.size(); }
+
+   private:
+      conn_t* least_outstanding()
+      {
+         // rotate the start so ties don't all land on the first connection
+         size_t   n    = conns.size();
+         size_t   from = next.fetch_add(1, std::memory_order_relaxed) % n;
+         conn_t*  best = conns[from].get();
+         uint32_t low  = best->outstanding.load(std::memory_order_relaxed);
+         for (size_t i = 1; i < n and low; ++i)
+         {
+            conn_t*  c  = conns[(from + i) % n].get();
+            uint32_t oc = c->outstanding.load(std::memory_order_relaxed);
+            if (oc < low)
+            {
+               best = c;
+               low  = oc;
+            }
+         }
+         return best;
+      }
+
+      std::vector<std::unique_ptr<conn_t>> conns;
+      std::atomic<size_t> next {0};
+   };
+}
+
+#endif//balanced_conns_h
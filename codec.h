@@ -0,0 +1,68 @@
+#ifndef codec_h
+#define codec_h
+
+#include <cstdint>
+#include <memory>
+
+#include "pdu/types.h"
+
+//! @brief Codecs: how PDUs are represented to the HTTP backend
+/** A codec turns a backend_request_t into a request body and a response body into a
+    backend_response_t; which one a backend speaks is its data-transfer-mode. <br>
+    The gateway only ever sees these two structs, so a codec is added by implementing codec_t and
+    naming it in make_codec() (codecs.h). Codecs are shared by every loop: they keep no state but
+    thread_local scratch buffers.
+*/
+
+namespace gateway
+{
+   /// What the backend is told about a PDU, the members used depend on @command
+   struct backend_request_t
+   {
+      uint32_t      command = 0;   ///< Begin/Continue: sid, length, msisdn, content. Abort: sid, length. Bind: status, length, system_id
+      uint32_t      sid     = 0;
+      uint32_t      length  = 0;
+      uint32_t      status  = 0;
+      string_view_t msisdn, content, system_id;
+   };
+
+   /// What the backend answers
+   struct backend_response_t
+   {
+      uint32_t      command = 0, op_type = 0;
+      string_view_t msisdn, content;
+      bool          has_command = false, has_op_type = false, has_msisdn = false, has_content = false, has_system_id = false;
+
+      /// Same rules as misc::check_json
+      bool valid() const
+      {
+         using cuap::pdu::CommandIDs;
+         if (!has_command)
+            return false;
+         if (command == CommandIDs::Begin or command == CommandIDs::Continue or command == CommandIDs::End)
+            return has_msisdn and has_content;
+         if (command == CommandIDs::Bind)
+            return has_system_id;
+         return false;
+      }
+   };
+
+   struct codec_t
+   {
+      virtual ~codec_t() = default;
+
+      virtual string_view_t name() const = 0;
+      virtual string_view_t content_type() const = 0;
+
+      /// @return the body, in a buffer of the calling thread valid until its next encode()
+      virtual string_view_t encode(const backend_request_t& req) const = 0;
+
+      /// @out may view @body or buffers of the calling thread, valid until its next decode()
+      /// @return false when @body doesn't decode or misses the members its command needs
+      virtual bool decode(string_view_t body, backend_response_t& out) const = 0;
+   };
+
+   using codec_ptr_t = std::unique_ptr<const codec_t>;
+}
+
+#endif//codec_h
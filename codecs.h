@@ -0,0 +1,431 @@
+#ifndef codecs_h
+#define codecs_h
+
+#include <json/json.h>
+
+#include "pdu/pdu.h"
+#include "codec.h"
+#include "json_writer.h"
+#include "json_reader.h"
+#include "xml_template.h"
+#include "xml_reader.h"
+#include "misc.h"
+#include "logger.h"
+
+//! @brief The codecs a backend can be configured with, see make_codec()
+/** json    : the original payloads, text, "sid" as "0x%08x".
+    msgpack : the same members as a MessagePack map, "sid" a plain integer. Half the size of the
+              JSON for a typical Continue and nothing to escape or unescape: strings are length
+              prefixed and decoded as views into the body.
+    xml     : the same members as child elements of <request>, "sid" as "0x%08x". Requests render
+              from templates compiled with the program (xml_template.h), responses are read in one
+              pass (xml_reader.h).
+*/
+
+namespace gateway
+{
+   struct json_codec_t final : codec_t
+   {
+      string_view_t name() const override         { return "json"; }
+      string_view_t content_type() const override { return "application/json"; }
+
+      string_view_t encode(const backend_request_t& req) const override
+      {
+         static thread_local json_writer_t payload;
+         using cuap::pdu::CommandIDs;
+
+         payload.clear().begin_object();
+         payload.field("command", req.command);
+         if (req.command == CommandIDs::Bind)
+         {
+            payload.field("pdu-status", req.status)
+                   .field("length", req.length)
+                   .field("system_id", req.system_id);
+         }
+         else
+         {
+            payload.field_hex("sid", req.sid)
+                   .field("length", req.length);
+            if (req.command != CommandIDs::Abort)   // When command is Begin, content is the service code
+               payload.field("msisdn", req.msisdn).field("content", req.content);
+         }
+         return payload.end_object().view();
+      }
+
+      /// One pass (json_reader.h), through a Json::Value only when the fast path can't
+      bool decode(string_view_t body, backend_response_t& out) const override
+      {
+         static thread_local json_reader_t reader;
+         static thread_local string        dom_msisdn, dom_content;
+
+         switch (reader.read(body, out))
+         {
+            case json_reader_t::status_t::ok:
+               return out.valid();
+
+            case json_reader_t::status_t::invalid:
+               return false;
+
+            case json_reader_t::status_t::fallback:
+               break;
+         }
+
+         try
+         {
+            Json::Value json;
+            if (!misc::parse_json(json, body) or !misc::check_json(json))
+               return false;
+
+            dom_msisdn  = json["msisdn"].asString();
+            dom_content = json["content"].asString();
+            out = {};
+            out.command       = json["command"].asUInt();
+            out.op_type       = json["op_type"].asUInt();
+            out.msisdn        = dom_msisdn;
+            out.content       = dom_content;
+            out.has_command   = true;
+            out.has_op_type   = json.isMember("op_type");
+            out.has_msisdn    = json.isMember("msisdn");
+            out.has_content   = json.isMember("content");
+            out.has_system_id = json.isMember("system_id");
+            return out.valid();
+         }
+         catch (std::exception& e)
+         {
+            logging::error("[ json_codec_t::decode exception ]: {}\n", e.what());
+            return false;
+         }
+      }
+   };
+
+   /// @brief MessagePack, https://github.com/msgpack/msgpack/blob/master/spec.md
+   /// Requests are a map of the JSON members. Responses must be a map; "command" and "op_type" are
+   /// unsigned integers, "msisdn" and "content" str or bin. Other members of any type are skipped.
+   struct msgpack_codec_t final : codec_t
+   {
+      string_view_t name() const override         { return "msgpack"; }
+      string_view_t content_type() const override { return "application/msgpack"; }
+
+      string_view_t encode(const backend_request_t& req) const override
+      {
+         static thread_local string buf;
+         using cuap::pdu::CommandIDs;
+
+         buf.clear();
+         if (req.command == CommandIDs::Bind)
+         {
+            map_header(buf, 4);
+            str(buf, "command");    uint(buf, req.command);
+            str(buf, "pdu-status"); uint(buf, req.status);
+            str(buf, "length");     uint(buf, req.length);
+            str(buf, "system_id");  str(buf, req.system_id);
+         }
+         else
+         {
+            bool abort = req.command == CommandIDs::Abort;
+            map_header(buf, abort ? 3 : 5);
+            str(buf, "command"); uint(buf, req.command);
+            str(buf, "sid");     uint(buf, req.sid);
+            str(buf, "length");  uint(buf, req.length);
+            if (!abort)
+            {
+               str(buf, "msisdn");  str(buf, req.msisdn);
+               str(buf, "content"); str(buf, req.content);
+            }
+         }
+         return buf;
+      }
+
+      bool decode(string_view_t body, backend_response_t& out) const override
+      {
+         out = {};
+         reader_t r { body.data(), body.data() + body.size() };
+
+         uint32_t n;
+         if (!r.map_header(n))
+            return false;
+
+         while (n--)
+         {
+            string_view_t key;
+            if (!r.text(key))
+               return false;
+
+            bool ok;
+            if (key == "command")
+               ok = r.uint(out.command) and (out.has_command = true);
+            else if (key == "op_type")
+               ok = r.uint(out.op_type) and (out.has_op_type = true);
+            else if (key == "msisdn")
+               ok = r.text(out.msisdn) and (out.has_msisdn = true);
+            else if (key == "content")
+               ok = r.text(out.content) and (out.has_content = true);
+            else
+            {
+               out.has_system_id |= key == "system_id";
+               ok = r.skip();
+            }
+            if (!ok)
+               return false;
+         }
+         return r.p == r.end and out.valid();
+      }
+
+   private:
+      static void put(string& buf, uint8_t tag, auto v)
+      {
+         char tmp[1 + sizeof(v)];
+         tmp[0] = char(tag);
+         cuap::pdu::big_endian<decltype(v)>(v).store(tmp + 1);
+         buf.append(tmp, sizeof(tmp));
+      }
+
+      static void map_header(string& buf, uint8_t n) { buf += char(0x80 | n); }   // fixmap, n < 16
+
+      static void uint(string& buf, uint32_t v)
+      {
+         if (v < 0x80)
+            buf += char(v);
+         else if (v <= 0xFF)
+            put(buf, 0xcc, uint8_t(v));
+         else if (v <= 0xFFFF)
+            put(buf, 0xcd, uint16_t(v));
+         else
+            put(buf, 0xce, v);
+      }
+
+      static void str(string& buf, string_view_t s)
+      {
+         if (s.size() < 32)
+            buf += char(0xa0 | s.size());
+         else if (s.size() <= 0xFF)
+            put(buf, 0xd9, uint8_t(s.size()));
+         else if (s.size() <= 0xFFFF)
+            put(buf, 0xda, uint16_t(s.size()));
+         else
+            put(buf, 0xdb, uint32_t(s.size()));
+         buf += s;
+      }
+
+      /// Bounds checked cursor over a response, every read fails rather than run past @end
+      struct reader_t
+      {
+         const char* p;
+         const char* end;
+
+         bool has(size_t n) const { return size_t(end - p) >= n; }
+
+         template <class T>
+         bool big(T& v)
+         {
+            if (!has(sizeof(T)))
+               return false;
+            v  = cuap::pdu::big_endian<T>::load(p).value();
+            p += sizeof(T);
+            return true;
+         }
+
+         /// Payload size of a str/bin/ext/array/map whose length follows the tag
+         bool length(uint8_t bytes, uint32_t& n)
+         {
+            uint8_t  n8;
+            uint16_t n16;
+            switch (bytes)
+            {
+               case 1:  if (!big(n8))  return false; n = n8;  return true;
+               case 2:  if (!big(n16)) return false; n = n16; return true;
+               default: return big(n);
+            }
+         }
+
+         bool map_header(uint32_t& n)
+         {
+            if (!has(1))
+               return false;
+            uint8_t t = uint8_t(*p++);
+            if ((t & 0xF0) == 0x80)
+            {
+               n = t & 0x0F;
+               return true;
+            }
+            return (t == 0xde or t == 0xdf) and length(t == 0xde ? 2 : 4, n);
+         }
+
+         /// Any unsigned integer, or a non negative signed one, that fits 32 bits
+         bool uint(uint32_t& v)
+         {
+            if (!has(1))
+               return false;
+            uint8_t t = uint8_t(*p++);
+            if (t < 0x80)
+            {
+               v = t;
+               return true;
+            }
+
+            uint64_t u;
+            switch (t)
+            {
+               case 0xcc: case 0xd0: { uint8_t  x; if (!big(x)) return false; u = t == 0xd0 ? uint64_t(int8_t(x))  : x; break; }
+               case 0xcd: case 0xd1: { uint16_t x; if (!big(x)) return false; u = t == 0xd1 ? uint64_t(int16_t(x)) : x; break; }
+               case 0xce: case 0xd2: { uint32_t x; if (!big(x)) return false; u = t == 0xd2 ? uint64_t(int32_t(x)) : x; break; }
+               case 0xcf: case 0xd3: { uint64_t x; if (!big(x)) return false; u = x; if (t == 0xd3 and int64_t(x) < 0) return false; break; }
+               default: return false;
+            }
+            if (u > 0xFFFFFFFFu)   // also a sign extended negative
+               return false;
+            v = uint32_t(u);
+            return true;
+         }
+
+         /// str or bin, as a view into the body
+         bool text(string_view_t& s)
+         {
+            if (!has(1))
+               return false;
+            uint8_t  t = uint8_t(*p++);
+            uint32_t n;
+            if ((t & 0xE0) == 0xa0)
+               n = t & 0x1F;
+            else if (t == 0xd9 or t == 0xc4)
+            {
+               if (!length(1, n)) return false;
+            }
+            else if (t == 0xda or t == 0xc5)
+            {
+               if (!length(2, n)) return false;
+            }
+            else if (t == 0xdb or t == 0xc6)
+            {
+               if (!length(4, n)) return false;
+            }
+            else
+               return false;
+
+            if (!has(n))
+               return false;
+            s  = { p, n };
+            p += n;
+            return true;
+         }
+
+         bool bytes(size_t n)
+         {
+            if (!has(n))
+               return false;
+            p += n;
+            return true;
+         }
+
+         /// Any value; nesting is bounded so a hostile body can't exhaust the stack
+         bool skip(int depth = 0)
+         {
+            if (!has(1) or depth > 32)
+               return false;
+            uint8_t  t = uint8_t(*p++);
+            uint32_t n;
+
+            if (t < 0x80 or t >= 0xe0 or t == 0xc0 or t == 0xc2 or t == 0xc3)   // fixint, nil, bool
+               return true;
+            if ((t & 0xE0) == 0xa0)                                          // fixstr
+               return bytes(t & 0x1F);
+            if ((t & 0xF0) == 0x80 or (t & 0xF0) == 0x90)                      // fixmap, fixarray
+            {
+               n = (t & 0x0F) * ((t & 0xF0) == 0x80 ? 2 : 1);
+               while (n--)
+                  if (!skip(depth + 1)) return false;
+               return true;
+            }
+
+            switch (t)
+            {
+               case 0xcc: case 0xd0: return bytes(1);
+               case 0xcd: case 0xd1: return bytes(2);
+               case 0xce: case 0xd2: case 0xca: return bytes(4);
+               case 0xcf: case 0xd3: case 0xcb: return bytes(8);
+               case 0xd4: return bytes(2);   // fixext 1..16: type + data
+               case 0xd5: return bytes(3);
+               case 0xd6: return bytes(5);
+               case 0xd7: return bytes(9);
+               case 0xd8: return bytes(17);
+               case 0xc4: case 0xd9: return length(1, n) and bytes(n);
+               case 0xc5: case 0xda: return length(2, n) and bytes(n);
+               case 0xc6: case 0xdb: return length(4, n) and bytes(n);
+               case 0xc7: return length(1, n) and bytes(size_t(n) + 1);
+               case 0xc8: return length(2, n) and bytes(size_t(n) + 1);
+               case 0xc9: return length(4, n) and bytes(size_t(n) + 1);
+               case 0xdc: case 0xdd: case 0xde: case 0xdf:
+               {
+                  if (!length(t == 0xdc or t == 0xde ? 2 : 4, n))
+                     return false;
+                  uint64_t items = uint64_t(n) * (t >= 0xde ? 2 : 1);
+                  if (!has(items))   // every item takes at least a byte
+                     return false;
+                  while (items--)
+                     if (!skip(depth + 1)) return false;
+                  return true;
+               }
+               default: return false;   // 0xc1, never used
+            }
+         }
+      };
+   };
+
+   /// @brief XML, the request templates and response format are in xml_template.h and xml_reader.h
+   struct xml_codec_t final : codec_t
+   {
+      static constexpr xml_template_t dialog_request {
+         "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         "<request><command>{command}</command><sid>{sid}</sid><length>{length}</length>"
+         "<msisdn>{msisdn}</msisdn><content>{content}</content></request>\n"
+      };
+      static constexpr xml_template_t abort_request {
+         "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         "<request><command>{command}</command><sid>{sid}</sid><length>{length}</length></request>\n"
+      };
+      static constexpr xml_template_t bind_request {
+         "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         "<request><command>{command}</command><pdu-status>{status}</pdu-status><length>{length}</length>"
+         "<system_id>{system_id}</system_id></request>\n"
+      };
+
+      string_view_t name() const override         { return "xml"; }
+      string_view_t content_type() const override { return "application/xml"; }
+
+      string_view_t encode(const backend_request_t& req) const override
+      {
+         static thread_local string buf;
+         using cuap::pdu::CommandIDs;
+
+         buf.clear();
+         if (req.command == CommandIDs::Bind)
+            bind_request.render(buf, req);
+         else if (req.command == CommandIDs::Abort)
+            abort_request.render(buf, req);
+         else
+            dialog_request.render(buf, req);
+         return buf;
+      }
+
+      bool decode(string_view_t body, backend_response_t& out) const override
+      {
+         static thread_local xml_reader_t reader;
+         return reader.read(body, out) and out.valid();
+      }
+   };
+
+   /// @brief The codec for a backend's data-transfer-mode: json | msgpack | xml
+   /// @return nullptr for a mode that isn't known
+   inline codec_ptr_t make_codec(string_view_t mode)
+   {
+      if (mode.empty() or mode == "json")
+         return std::make_unique<json_codec_t>();
+      if (mode == "msgpack")
+         return std::make_unique<msgpack_codec_t>();
+      if (mode == "xml")
+         return std::make_unique<xml_codec_t>();
+      return nullptr;
+   }
+}
+
+#endif//codecs_h
@@ -25,12 +25,19 @@ namespace config
       struct app_t
       {
          string mode    = "gateway"; // single: display welcome page only, multi: talks to http backend. gateway
-         uint   threads = 4;
+         uint   threads = 4;          // worker loops the dialogs are spread over
+         string log_level = "info";   // debug | info | warn | error | off
       } app;
 
       struct client_t
       {
          string host, port, url;
+         uint   connections       = 4;   // persistent connections to the backend
+         uint   loops             = 2;   // event loops the connections are spread over
+         uint   max_outstanding   = 64;  // requests in flight per connection
+         uint   keepalive_timeout = 60;  // secs a connection may stay idle before it's closed
+         uint   timeout           = 5;   // secs per request
+         string data_transfer_mode = "json";   // json | msgpack | xml, the codec this backend speaks
          struct error_t
          {
             string could_not_fetch = "Your message could not be processed at this time. Please try again later. [err=could-not-fetch]",
@@ -44,8 +51,24 @@ namespace config
       struct cuap_t
       {
          string host, system_id, password, system_type, interface_version, welcome_page;
+         string white_list;            // MSISDNs served, one per line, or a snapshot; empty serves everyone
+         string white_list_snapshot;   // binary snapshot of white_list, rebuilt when older; empty: white_list + ".snapshot"
+         bool   white_list_watch = true; // reload white_list and number_rules when their files change, SIGHUP always reloads them
+         string number_rules;          // allow/deny rules by MSISDN prefix, range or number, see number_rules.h
          unsigned short  port;
+         uint     session_timeout = 180;   // secs a dialog may stay idle before it's dropped
+         uint     max_sessions    = 65536; // concurrent dialogs per link
+         uint     shake_interval  = 30;    // secs between Shake messages
+         uint     shake_max_missed = 3;    // unanswered Shakes before the link is declared dead
+         uint     reconnect_min_ms = 100;  // first reconnect delay, doubles per failed attempt
+         uint     reconnect_max_ms = 30000;
          client_t client;
+
+         struct plugin_t
+         {
+            string service_code, library, config;
+         };
+         vector<plugin_t> plugins;   // service codes answered in process instead of by client, see plugin/cuap_plugin.h
       };
 
       auto& operator[](const string& key) { return root[key]; }
@@ -99,7 +122,8 @@ namespace config
          auto use_json = [&]()
          {
             app.mode    = root["app"]["mode"].asString();
-            app.threads = root["app"]["threads"].asUInt();
+            app.threads = root["app"].get("threads", app.threads).asUInt();
+            app.log_level = root["app"].get("log-level", app.log_level).asString();
 
             gateway.host = root["gateway"]["host"].asString();
             gateway.port = root["gateway"]["port"].asUInt();
@@ -111,8 +135,37 @@ namespace config
             gateway.interface_version  = root["gateway"]["interface-version"].asString();
             gateway.welcome_page       = root["gateway"]["welcome-page"].asString();
 
+            gateway.white_list          = root["gateway"].get("white-list", "").asString();
+            gateway.white_list_snapshot = root["gateway"].get("white-list-snapshot", "").asString();
+            gateway.white_list_watch    = root["gateway"].get("white-list-watch", gateway.white_list_watch).asBool();
+            gateway.number_rules        = root["gateway"].get("number-rules", "").asString();
+
+            gateway.session_timeout    = root["gateway"].get("session-timeout", gateway.session_timeout).asUInt();
+            gateway.max_sessions       = root["gateway"].get("max-sessions", gateway.max_sessions).asUInt();
+            gateway.shake_interval     = root["gateway"].get("shake-interval", gateway.shake_interval).asUInt();
+            gateway.shake_max_missed   = root["gateway"].get("shake-max-missed", gateway.shake_max_missed).asUInt();
+            gateway.reconnect_min_ms   = root["gateway"].get("reconnect-min-ms", gateway.reconnect_min_ms).asUInt();
+            gateway.reconnect_max_ms   = root["gateway"].get("reconnect-max-ms", gateway.reconnect_max_ms).asUInt();
+
+            gateway.plugins.clear();
+            for (const auto& plugin : root["gateway"]["plugins"])
+            {
+               gateway.plugins.push_back({ plugin["service-code"].asString(), plugin["library"].asString(),
+                                           plugin.get("config", "").asString() });
+            }
+
             gateway.client.url         = root["gateway"]["client"]["url"].asString();
 
+            auto& client = root["gateway"]["client"];
+            gateway.client.connections       = client.get("connections", gateway.client.connections).asUInt();
+            gateway.client.loops             = client.get("loops", gateway.client.loops).asUInt();
+            gateway.client.max_outstanding   = client.get("max-outstanding", gateway.client.max_outstanding).asUInt();
+            gateway.client.keepalive_timeout = client.get("keepalive-timeout", gateway.client.keepalive_timeout).asUInt();
+            gateway.client.timeout           = client.get("timeout", gateway.client.timeout).asUInt();
+            // gateway.data-transfer-mode is the older spelling, still read when the client doesn't set one
+            gateway.client.data_transfer_mode = client.get("data-transfer-mode",
+               root["gateway"].get("data-transfer-mode", gateway.client.data_transfer_mode)).asString();
+
             gateway.client.error.could_not_fetch     = root["gateway"]["client"]["error"]["could-not-fetch"].asString();
             gateway.client.error.invalid_data        = root["gateway"]["client"]["error"]["invalid-data"].asString();
             gateway.client.error.request_failed      = root["gateway"]["client"]["error"]["request-failed"].asString();
@@ -12,6 +12,16 @@
 
 #include "misc.h"
 #include "config.h"
+#include "logger.h"
+#include "session.h"
+#include "worker.h"
+#include "request_pool.h"
+#include "keepalive.h"
+#include "reconnect.h"
+#include "backend.h"
+#include "white_list.h"
+#include "codecs.h"
+#include "plugins.h"
 
 using namespace trantor;
 using namespace drogon;
@@ -49,44 +59,24 @@ namespace gateway
 
    namespace send
    {
-      namespace samples
+      /// Answers a Shake from the USSDC
+      void shake_resp(tcp_client_t client, tcp_conn_t conn)
       {
-         uint8_t unbind[] =
-         {
-            0x14, 0x00, 0x00, 0x00, 0x66, 0x00, 0x00, 0x00,
-            0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
-            0xff, 0xff, 0xff, 0xff
-         };
-
-         uint8_t shake[] =
-         {
-            0x14, 0x00, 0x00, 0x00, 0x83, 0x00, 0x00, 0x00,
-            0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
-            0xff, 0xff, 0xff, 0xff
-         };
-      }
-
-      void shake(tcp_client_t client, tcp_conn_t conn, msg_buffer_t msg)
-      {
-         pdu::shake_msg_t shake (samples::shake, sizeof(samples::shake));
-         shake.encode_header();
-         conn->send(shake, shake.capacity());
+         static pdu::shake_resp_t shake_resp;
+         conn->send(shake_resp, shake_resp.capacity());
       #ifdef ENABLE_PDU_LOG
-         fmt::print_cyan("\n{}. [ {}::shake info ]: Sent Shake Message to: {}\n",
-            misc::current_time(), client->name(), conn->peerAddr().toIpPort()
+         logging::debug("[ {}::shake_resp info ]: Sent ShakeResp Message to: {}\n",
+            client->name(), conn->peerAddr().toIpPort()
          );
-         misc::print_pdu(samples::shake, sizeof(samples::shake));
       #endif
-         std::this_thread::sleep_for (std::chrono::milliseconds(250));
       }
 
       void unbind(tcp_client_t client, tcp_conn_t conn, msg_buffer_t msg)
       {
-         pdu::unbind_msg_t unbind (samples::unbind, sizeof(samples::unbind));
-         unbind.encode_header();
+         static pdu::unbind_msg_t unbind;   // header built and encoded once
          conn->send(unbind, unbind.capacity());
-         fmt::print_cyan("\n{}. [{}::on_message]: Sent UnBind Message to: {}\n",
-            misc::current_time(), client->name(), conn->peerAddr().toIpPort()
+         logging::info("[ {}::on_message info ]: Sent UnBind Message to: {}\n",
+            client->name(), conn->peerAddr().toIpPort()
          );
          #ifdef ENABLE_PDU_LOG
             misc::print_pdu(unbind);
@@ -101,41 +91,64 @@ namespace gateway
          {
             if (result == ReqResult::Ok && response)
             {
-               fmt::print_green("{}. [ send::db_request info ]: Data submitted to dB handler\n", misc::current_time());
+               logging::info("[ send::db_request info ]: Data submitted to dB handler\n");
             }
             else
             {
-               fmt::print_yellow("{}. [ send::db_request info ]: Data not submitted to dB handler, saving...\n", misc::current_time());
+               logging::warn("[ send::db_request info ]: Data not submitted to dB handler, saving...\n");
             }
-            fmt::print(std::flush(std::cout), "");
          });
       }
    }
 
    struct gateway_t
    {
-      enum class data_transfer_mode_t { json, xml };
-
       gateway_t(misc::cli_config_t& config);
 
-      void build_whitelist();
+      using white_list_ptr_t   = std::shared_ptr<const white_list_t>;
+      using number_rules_ptr_t = std::shared_ptr<const number_rules_t>;
+      white_list_ptr_t   load_whitelist();
+      number_rules_ptr_t load_number_rules();
+      void reload_admission();
+      bool admit(const worker_t& worker, const pdu::begin_view_t& req, pdu::msisdn_key_t msisdn);
 
-      void build_abort(pdu_type&,     auto&&);
-      void build_begin(pdu_type&,     pdu_type&, auto&&);
-      void build_continue(pdu_type&,  pdu_type&, auto&&);
+      void build_abort(const pdu::abort_view_t&, auto&&);
+      void build_begin(pdu::begin_fields_t&,       const pdu::begin_view_t&, auto&&);
+      void build_continue(pdu::continue_fields_t&, const pdu::continue_view_t&, auto&&);
+      void build_plugin(const plugin_t&, pdu::begin_fields_t&, const pdu::begin_view_t&, string_view_t msisdn,
+                        const pdu::service_code_t&, worker_t&, auto&&);
+      void plugin_reply(pdu::begin_fields_t& pdu, uint32_t sid, int status, const cuap_response_t* resp);
 
       template <command_id request_type = command_id::begin>
-      auto build_http_request(pdu_type& packet);
+      auto build_http_request(const auto& packet);
       void send_http_request(HttpRequestPtr& req);
 
       void init();
+      void connect();
+      void schedule_reconnect();
+
+      void set_link_state(link_state_t state);
+      link_state_t link_state() const { return state; }
 
       void on_connect(tcp_conn_t conn);
       void on_conn_error();
       void on_message(tcp_conn_t conn, msg_buffer_t msg);
+      void on_pdu(tcp_conn_t conn, string_view_t data);
+
+      /// Handlers registered in pdu_handlers, run on the TCP loop
+      using pdu_handler_t = void (gateway_t::*)(tcp_conn_t, string_view_t, const pdu::header_t&);
+      void on_bind_resp(tcp_conn_t conn, string_view_t data, const pdu::header_t& hdr);
+      void on_unbind_resp(tcp_conn_t conn, string_view_t data, const pdu::header_t& hdr);
+      void on_shake(tcp_conn_t conn, string_view_t data, const pdu::header_t& hdr);
+      void on_shake_resp(tcp_conn_t conn, string_view_t data, const pdu::header_t& hdr);
+      void dispatch(tcp_conn_t conn, string_view_t data, const pdu::header_t& hdr);
+      void on_dialog_pdu(request_ctx_t* ctx);
+      void send_reply(request_ctx_t* ctx);
+      void close_session_on_end(worker_t& worker, const pdu::end_fields_t& pdu);
 
       void setup_config();
       void setup_data_transfer_mode();
+      void load_plugins();
 
       void run();
 
@@ -143,309 +156,478 @@ namespace gateway
       config::config_t     cfg;
 
       EventLoopThread      evloop_tcp  = EventLoopThread{"eventloop.thread.tcp"};
-      EventLoopThread      evloop_http = EventLoopThread{"eventloop.thread.http"};
       InetAddress          addr;
       tcp_client_t         tcp_client;
-      HttpClientPtr        http_client;
+      backend_t            backend;
 
       pdu::bind_msg_t      bindmsg;
       pdu::unbind_msg_t    unbindmsg;
 
-      std::set<string>     white_list;
-      data_transfer_mode_t data_transfer_mode = data_transfer_mode_t::json;
+      plugins_t            plugins;   ///< before workers, so it outlives every call into a plugin
+      worker_pool_t        workers;
+      request_pool_t       requests;
+      keepalive_t          keepalive;
+      reconnect_t          reconnect;
+      link_state_t         state = link_state_t::idle;
+      codec_ptr_t          codec;   ///< how the backend is spoken to, from gateway.client.data-transfer-mode
+      struct
+      {
+         white_list_ptr_t   white_list;
+         number_rules_ptr_t number_rules;
+      } admission;   ///< last loaded, only touched by reload_admission()
+
+      white_list_watcher_t white_list_watcher;   ///< last, so it's stopped before the workers it publishes to go
+   };
+
+   /// @brief Inbound commands the gateway acts on.
+   /// Begin, Continue and Abort belong to a dialog and are handed to its worker. End, and the
+   /// commands only a SA sends, are known but have no handler: they're length checked and dropped.
+   inline constexpr pdu::dispatch_table<gateway_t::pdu_handler_t> pdu_handlers
+   {
+      { CommandIDs::BindResp,   &gateway_t::on_bind_resp   },
+      { CommandIDs::UnBindResp, &gateway_t::on_unbind_resp },
+      { CommandIDs::Shake,      &gateway_t::on_shake       },
+      { CommandIDs::ShakeResp,  &gateway_t::on_shake_resp  },
+      { CommandIDs::Begin,      &gateway_t::dispatch       },
+      { CommandIDs::Continue,   &gateway_t::dispatch       },
+      { CommandIDs::Abort,      &gateway_t::dispatch       },
    };
 
    gateway_t::gateway_t(misc::cli_config_t& config) : cli_cfg(config)
    {
    }
 
-   void gateway_t::build_whitelist()
+   /// Loads the configured white-list, from the watcher's thread too
+   gateway_t::white_list_ptr_t gateway_t::load_whitelist()
    {
-      auto& config = this->cfg;
-      string tmp, file = config["gateway"]["white-list"].asString();
-      fstream ifs (file, fstream::in);
-      if (!ifs.is_open())
+      const string& file     = cfg.gateway.white_list;
+      const string  snapshot = cfg.gateway.white_list_snapshot.empty() ? file + ".snapshot" : cfg.gateway.white_list_snapshot;
+
+      auto list  = std::make_shared<white_list_t>();
+      auto start = std::chrono::steady_clock::now();
+      if (!list->load(file, snapshot))
       {
-         fmt::print_yellow("{}. [ gateway_t::build_whitelist info ]: '{}' not found.\n", misc::current_time(), file);
-         return;
+         logging::warn("[ gateway_t::load_whitelist info ]: '{}' not found.\n", file);
+         return nullptr;
       }
-      while (getline(ifs, tmp))
+      auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+      if (list->rejected)
+         logging::warn("[ gateway_t::load_whitelist warn ]: {} line(s) of '{}' are not MSISDNs, skipped.\n", list->rejected, file);
+      logging::info("[ gateway_t::load_whitelist info ]: Whitelist of {} MSISDN(s) {} '{}' in {} ms\n",
+         list->size(), list->source == white_list_t::source_t::snapshot ? "mapped from snapshot of" : "parsed from", file, ms
+      );
+      return list;
+   }
+
+   /// Loads the configured number rules, from the watcher's thread too
+   gateway_t::number_rules_ptr_t gateway_t::load_number_rules()
+   {
+      const string& file = cfg.gateway.number_rules;
+      auto rules = std::make_shared<number_rules_t>();
+      if (!rules->load(file))
       {
-         white_list.insert(tmp);
-         #ifdef ENABLE_PDU_LOG
-            fmt::print("{}\n", tmp);
-         #endif
+         logging::warn("[ gateway_t::load_number_rules info ]: '{}' not found.\n", file);
+         return nullptr;
       }
-      fmt::print_green("{}. [ gateway_t::build_whitelist info ]: Whitelist built from '{}'\n", misc::current_time(), file);
+      if (rules->rejected)
+         logging::warn("[ gateway_t::load_number_rules warn ]: {} line(s) of '{}' are not rules, skipped.\n", rules->rejected, file);
+      logging::info("[ gateway_t::load_number_rules info ]: Number rules loaded from '{}'\n", file);
+      return rules;
    }
 
-   void gateway_t::build_abort(pdu_type& pdu_req, auto&& fn)
+   /// (Re)loads the white-list and number rules, then hands them to every worker, each swaps them in
+   /// on its own loop. Whatever fails to load stays as it was. Runs at startup, then on the watcher's thread only.
+   void gateway_t::reload_admission()
    {
-      static char fn_name[] = "build_abort";
+      if (!cfg.gateway.white_list.empty())
+      {
+         if (white_list_ptr_t list = load_whitelist())
+            admission.white_list = std::move(list);
+      }
+      if (!cfg.gateway.number_rules.empty())
+      {
+         if (number_rules_ptr_t rules = load_number_rules())
+            admission.number_rules = std::move(rules);
+      }
+      workers.each([list = admission.white_list, rules = admission.number_rules](worker_t& w)
+      {
+         w.white_list   = list;
+         w.number_rules = rules;
+      });
+   }
+
+   /// @brief Runs on the dialog's worker, before a session is opened for the Begin.
+   /// A deny rule always refuses, an allow rule always admits. Otherwise, when there is a white-list or
+   /// any allow rule the MSISDN has to be on the white-list, and everyone is served when there is neither.
+   bool gateway_t::admit(const worker_t& worker, const pdu::begin_view_t& req, pdu::msisdn_key_t msisdn)
+   {
+      if (!msisdn)
+      {
+         logging::warn("[ gateway_t::admit warn ]: '{}' is not a valid MSISDN, not serving.\n", req.msisdn().view());
+         return false;
+      }
+
+      const number_rules_t* rules = worker.number_rules.get();
+      const white_list_t*   list  = worker.white_list.get();
+      if (rules)
+      {
+         switch (rules->check(msisdn))
+         {
+            case number_rules_t::verdict_t::deny:
+               logging::warn("[ gateway_t::admit warn ]: '{}' denied by number rules, not serving.\n", req.msisdn().view());
+               return false;
+
+            case number_rules_t::verdict_t::allow:
+               return true;
+
+            default:
+               break;
+         }
+      }
 
-      pdu_req.decode_header();
+      bool restricted = (list and !list->empty()) or (rules and rules->has_allow());
+      if (restricted and !(list and list->contains(msisdn)))
+      {
+         logging::warn("[ gateway_t::admit warn ]: '{}' not found in white-list, not serving.\n", req.msisdn().view());
+         return false;
+      }
+      return true;
+   }
+
+   void gateway_t::build_abort(const pdu::abort_view_t& pdu_req, auto&& fn)
+   {
+      static char fn_name[] = "build_abort";
 
       auto sender_id   = pdu_req.sender_id();
       auto receiver_id = pdu_req.receiver_id();
 
-      fmt::print("{}. [ gateway::build_abort info ]: request: {}", misc::current_time(),
-         fmt::format(fmt_req_begin, sender_id, receiver_id, "", "", "")
-      );
+      logging::info(fmt_log_request, fn_name, sender_id, receiver_id, "", "", "");
 
       HttpRequestPtr req = build_http_request<command_id::abort>(pdu_req);
-      http_client->sendRequest(req, [&/*, tconn = std::move(conn)*/](ReqResult result, const HttpResponsePtr& response)
+      backend.send(req, [this, pdu_req, fn = std::forward<decltype(fn)>(fn)](ReqResult result, const HttpResponsePtr& response)
       {
          if (result == ReqResult::Ok && response)
          {
-            Json::Value json;
-            if (misc::parse_json(json, response->getBody()) and misc::check_json(json))
+            backend_response_t resp;
+            if (codec->decode(response->getBody(), resp))
             {
-               fmt::print_green("{}. [ gateway::build_abort info ]: response: {}\n", misc::current_time(), response->getBody());
+               logging::info("[ gateway::build_abort info ]: response: {}\n", response->getBody());
             }
             else
             {
-               fmt::print_red("{}. [ gateway::build_abort error ]: Unable to parse JSON response: {}\n", misc::current_time(), response->body());
+               logging::error("[ gateway::build_abort error ]: Unable to parse JSON response: {}\n", response->body());
             }
          }
          else
          {
-            fmt::print_red("{}. [ gateway::build_abort error ]: request to {} failed\n",
-               misc::current_time(), cfg.gateway.client.url
-            );
+            logging::error("[ gateway::build_abort error ]: request to {} failed\n", cfg.gateway.client.url);
          }
 
          #ifdef ENABLE_PDU_LOG
-            misc::print_pdu(pdu_req, pdu_req.command_len());
+            misc::print_pdu(pdu_req.data(), pdu_req.size());
          #endif
          fn();
       });
 
    }
 
-   void gateway_t::build_begin(pdu_type& pdu, pdu_type& pdu_req, auto&& fn)
+   void gateway_t::build_begin(pdu::begin_fields_t& pdu, const pdu::begin_view_t& pdu_req, auto&& fn)
    {
       static char fn_name[] = "build_begin";
 
-      pdu_req.decode_header();
-      string msisdn = pdu_req.msisdn();
-      if (!white_list.empty() and !white_list.contains(msisdn))
-      {
-         fmt::print_yellow("{}. [ gateway_t::build_begin warn ]: '{}' not found in white-list, not serving.\n", misc::current_time(), msisdn);
-         return ;
-      }
+      pdu::msisdn_t msisdn = pdu_req.msisdn();
 
       auto sender_id   = pdu_req.sender_id();
       auto receiver_id = pdu_req.receiver_id();
       auto op          = pdu_req.ussd_op_type();
 
-      string service_code = pdu_req.service_code();
-      string content      = pdu_req.ussd_content();
+      pdu::service_code_t service_code = pdu_req.service_code();
+      string_view_t       content      = pdu_req.ussd_content();
 
-      fmt::print("{}. [ gateway::build_begin info ]: request: {}", misc::current_time(),
-         fmt::format(fmt_req_begin, sender_id, receiver_id, content, op_name(op), msisdn)
-      );
+      logging::info(fmt_log_request, fn_name, sender_id, receiver_id, content, op_name(op), msisdn.view());
 
-      pdu.set_command_status(0);
-      pdu.set_receiver_id(sender_id);
-      pdu.set_ussd_ver(pdu::UssdVersion::PHASEII);
-      pdu.set_msisdn(msisdn);
-      pdu.set_service_code(service_code);
-      pdu.set_code_scheme(pdu::CodeScheme::Ox0F);
+      pdu.command_status = 0;
+      pdu.receiver_id    = sender_id;
+      pdu.ussd_ver       = pdu::UssdVersion::PHASEII;
+      pdu.msisdn         = msisdn;
+      pdu.service_code   = service_code;
+      pdu.code_scheme    = pdu::CodeScheme::Ox0F;
 
       HttpRequestPtr req = build_http_request<command_id::begin>(pdu_req);
-      http_client->sendRequest(req, [&](ReqResult result, const HttpResponsePtr& response)
+      backend.send(req, [this, &pdu, sender_id, fn = std::forward<decltype(fn)>(fn)](ReqResult result, const HttpResponsePtr& response)
       {
          if (result == ReqResult::Ok && response)
          {
-            Json::Value json;
-            if (misc::parse_json(json, response->getBody()) and misc::check_json(json))
+            backend_response_t resp;
+            if (codec->decode(response->getBody(), resp))
             {
-               try
-               {
-                  fmt::print_green("{}. [ gateway::build_begin info ]: response: {}\n", misc::current_time(), response->getBody());
-                  pdu.set_ussd_content(json["content"].asCString());
-                  pdu.set_ussd_op_type(json["op_type"].asUInt());
-                  pdu.set_command_id(json["command"].asUInt());
-               }
-               catch(std::exception& e)
-               {
-                  fmt::print_red("{}. [ gateway::build_begin exception ]: {}\n", misc::current_time(), e.what());
-                  pdu.set_command_id(pdu::CommandIDs::End);
-               }
+               logging::info("[ gateway::build_begin info ]: response: {}\n", response->getBody());
+               pdu.content    = resp.content;
+               pdu.op_type    = resp.op_type;
+               pdu.command_id = resp.command;
             }
             else
             {
-               fmt::print_red("{}. [ gateway::build_begin error ]: Unable to parse JSON response: {}\n",
-                  misc::current_time(), response->body()
-               );
-               fmt::print_red(fmt_data_error, misc::current_time(), fn_name, sender_id, cfg.gateway.client.error.invalid_data);
-               pdu.set_command_id(pdu::CommandIDs::End);
-               pdu.set_ussd_op_type(pdu::USSDOperationTypes::USSN);
-               pdu.set_ussd_content(cfg.http.error.invalid_data);
+               logging::error("[ gateway::build_begin error ]: Unable to parse JSON response: {}\n", response->body());
+               logging::error(fmt_data_error, fn_name, sender_id, cfg.gateway.client.error.invalid_data);
+               pdu.command_id = pdu::CommandIDs::End;
+               pdu.op_type    = pdu::USSDOperationTypes::USSN;
+               pdu.content    = cfg.http.error.invalid_data;
             }
          }
          else
          {
-            fmt::print_red(fmt_req_error, misc::current_time(), fn_name, cfg.gateway.client.url, sender_id,
+            logging::error(fmt_req_error, fn_name, cfg.gateway.client.url, sender_id,
                 cfg.gateway.client.error.request_failed
             );
-            pdu.set_ussd_op_type(pdu::USSDOperationTypes::USSN);
-            pdu.set_command_id(pdu::CommandIDs::End);
-            pdu.set_ussd_content(cfg.gateway.client.error.request_failed);
+            pdu.op_type    = pdu::USSDOperationTypes::USSN;
+            pdu.command_id = pdu::CommandIDs::End;
+            pdu.content    = cfg.gateway.client.error.request_failed;
          }
 
-         pdu.set_command_len();
-         pdu.encode_header();
-
-         #ifdef ENABLE_PDU_LOG
-            misc::print_pdu(pdu, be32toh(pdu.command_len()));
-         #endif
          fn();
       });
-
    }
 
-   void gateway_t::build_continue(pdu_type& pdu, pdu_type& pdu_req, auto&& fn)
+   void gateway_t::build_continue(pdu::continue_fields_t& pdu, const pdu::continue_view_t& pdu_req, auto&& fn)
    {
       static char fn_name[] = "build_continue";
 
-      pdu_req.decode_header();
-
       auto sender_id   = pdu_req.sender_id();
       auto receiver_id = pdu_req.receiver_id();
       auto op          = pdu_req.ussd_op_type();
 
-      string msisdn       = pdu_req.msisdn();
-      string service_code = pdu_req.service_code();
-      string ussd_content = pdu_req.ussd_content();
+      pdu::msisdn_t       msisdn       = pdu_req.msisdn();
+      pdu::service_code_t service_code = pdu_req.service_code();
 
-      fmt::print("{}. [ gateway::build_continue info ]: request: {}", misc::current_time(),
-         fmt::format(fmt_req_begin, sender_id, receiver_id, service_code, op_name(op), msisdn)
-      );
+      logging::info(fmt_log_request, fn_name, sender_id, receiver_id, service_code.view(), op_name(op), msisdn.view());
 
-      pdu.set_command_status(0);
-      pdu.set_receiver_id(sender_id);
-      pdu.set_ussd_ver(pdu::UssdVersion::PHASEII);
-      pdu.set_msisdn(msisdn);
-      pdu.set_service_code(service_code);
-      pdu.set_code_scheme(pdu::CodeScheme::Ox0F);
+      pdu.command_status = 0;
+      pdu.receiver_id    = sender_id;
+      pdu.ussd_ver       = pdu::UssdVersion::PHASEII;
+      pdu.msisdn         = msisdn;
+      pdu.service_code   = service_code;
+      pdu.code_scheme    = pdu::CodeScheme::Ox0F;
 
       HttpRequestPtr req = build_http_request<command_id::continue_>(pdu_req);
-      http_client->sendRequest(req, [&](ReqResult result, const HttpResponsePtr& response)
+      backend.send(req, [this, &pdu, sender_id, fn = std::forward<decltype(fn)>(fn)](ReqResult result, const HttpResponsePtr& response)
       {
          if (result == ReqResult::Ok && response)
          {
-            Json::Value json;
-            if (misc::parse_json(json, response->getBody()) and misc::check_json(json))
+            backend_response_t resp;
+            if (codec->decode(response->getBody(), resp))
             {
-               try
-               {
-                  fmt::print_green("{}. [ gateway::build_continue info ]: response: {}\n", misc::current_time(), response->getBody());
-                  pdu.set_ussd_content(json["content"].asString());
-                  pdu.set_ussd_op_type(json["op_type"].asUInt());
-                  pdu.set_command_id(json["command"].asUInt());
-               }
-               catch(std::exception& e)
-               {
-                  fmt::print_red("{}. [ gateway::build_continue exception ]: {}\n", misc::current_time(), e.what());
-                  pdu.set_command_id(pdu::CommandIDs::End);
-               }
+               logging::info("[ gateway::build_continue info ]: response: {}\n", response->getBody());
+               pdu.content    = resp.content;
+               pdu.op_type    = resp.op_type;
+               pdu.command_id = resp.command;
             }
             else
             {
-               fmt::print_red("{}. [ gateway::build_continue error ]: Unable to parse JSON response: {}\n", misc::current_time(), response->body());
-               fmt::print_red(fmt_data_error, misc::current_time(), fn_name, sender_id, cfg.gateway.client.error.invalid_data);
-               pdu.set_command_id(pdu::CommandIDs::End);
-               pdu.set_ussd_op_type(pdu::USSDOperationTypes::USSN);
-               pdu.set_ussd_content(cfg.gateway.client.error.invalid_data);
+               logging::error("[ gateway::build_continue error ]: Unable to parse JSON response: {}\n", response->body());
+               logging::error(fmt_data_error, fn_name, sender_id, cfg.gateway.client.error.invalid_data);
+               pdu.command_id = pdu::CommandIDs::End;
+               pdu.op_type    = pdu::USSDOperationTypes::USSN;
+               pdu.content    = cfg.gateway.client.error.invalid_data;
             }
          }
          else
          {
-            fmt::print_red(fmt_req_error, misc::current_time(), fn_name, cfg.gateway.client.url, sender_id,
+            logging::error(fmt_req_error, fn_name, cfg.gateway.client.url, sender_id,
                cfg.gateway.client.error.could_not_fetch
             );
-            pdu.set_ussd_op_type(pdu::USSDOperationTypes::USSN);
-            pdu.set_command_id(pdu::CommandIDs::End);
-            pdu.set_ussd_content(cfg.gateway.client.error.could_not_fetch);
+            pdu.op_type    = pdu::USSDOperationTypes::USSN;
+            pdu.command_id = pdu::CommandIDs::End;
+            pdu.content    = cfg.gateway.client.error.could_not_fetch;
          }
 
-         pdu.set_command_len();
-         pdu.encode_header();
-
-         #ifdef ENABLE_PDU_LOG
-            misc::print_pdu(pdu, be32toh(pdu.command_len()));
-         #endif
          fn();
       });
 
    }
 
-   template <command_id request_type = command_id::begin>
-   auto gateway_t::build_http_request(pdu_type& packet)
+   /// @brief Serves a Begin, Continue or Abort with the plugin registered for its service code, in place
+   /// of the HTTP backend. Runs on the dialog's worker, as does @fn: right away when the plugin answers
+   /// in handle(), queued back to the worker when it completes from another thread.
+   void gateway_t::build_plugin(const plugin_t& plugin, pdu::begin_fields_t& pdu, const pdu::begin_view_t& pdu_req,
+                                string_view_t msisdn, const pdu::service_code_t& service_code, worker_t& worker, auto&& fn)
    {
-      static char frmt_begin[] = R"({{ "command": {}, "sid": "0x{:08x}", "length": {}, "msisdn": "{}", "content": "{}" }})""\n";
+      static char fn_name[] = "build_plugin";
+
+      bool abort       = pdu_req.command_id() == CommandIDs::Abort;   // header only, no body to read
+      auto sender_id   = pdu_req.sender_id();
+      auto receiver_id = pdu_req.receiver_id();
+      auto op          = abort ? uint8_t(0) : pdu_req.ussd_op_type();
+
+      cuap_request_t request {};
+      request.command      = pdu_req.command_id();
+      request.sid          = sender_id;
+      request.op_type      = op;
+      request.msisdn       = { msisdn.data(), msisdn.size() };
+      request.service_code = { service_code.c_str(), service_code.size() };
+      if (!abort)
+      {
+         string_view_t content = pdu_req.ussd_content();
+         request.content = { content.data(), content.size() };
+      }
 
+      logging::info(fmt_log_request, fn_name, sender_id, receiver_id, service_code.view(), abort ? "" : op_name(op), msisdn);
+
+      pdu.command_status = 0;
+      pdu.receiver_id    = sender_id;
+      pdu.ussd_ver       = pdu::UssdVersion::PHASEII;
+      pdu.msisdn         = msisdn;
+      pdu.service_code   = service_code;
+      pdu.code_scheme    = pdu::CodeScheme::Ox0F;
+
+      /// Outlives handle() when the plugin answers later, the reply is filled in on the plugin's thread
+      struct call_t
+      {
+         gateway_t*            self;
+         pdu::begin_fields_t*  pdu;
+         uint32_t              sid;
+         bool                  abort;
+         trantor::EventLoop*   loop;
+         std::function<void()> fn;
+      };
+      auto call = std::make_unique<call_t>(call_t { this, &pdu, sender_id, abort, worker.loop, std::forward<decltype(fn)>(fn) });
+
+      cuap_complete_fn complete = [](void* token, int status, const cuap_response_t* resp)
+      {
+         call_t* c = static_cast<call_t*>(token);
+         if (!c->abort)
+            c->self->plugin_reply(*c->pdu, c->sid, status, resp);
+         else if (status == CUAP_ERROR)
+            logging::error("[ gateway::build_plugin error ]: plugin failed the Abort of sid: 0x{:08x}\n", c->sid);
+         c->loop->queueInLoop([c] { std::unique_ptr<call_t> done(c); done->fn(); });
+      };
+
+      cuap_response_t resp {};
+      int status = plugin.api->handle(plugin.instance, &request, &resp, complete, call.get());
+      if (status == CUAP_PENDING)
+      {
+         call.release();   // complete() owns it now
+         return;
+      }
+      // Nothing goes back for an Abort, @resp is ignored
+      if (!abort)
+         plugin_reply(pdu, sender_id, status, &resp);
+      else if (status == CUAP_ERROR)
+         logging::error("[ gateway::build_plugin error ]: plugin failed the Abort of sid: 0x{:08x}\n", sender_id);
+      call->fn();
+   }
+
+   /// Copies a plugin's answer into the reply, or the configured error when it has none.
+   /// On the worker, or on the plugin's thread for an answer given through complete().
+   void gateway_t::plugin_reply(pdu::begin_fields_t& pdu, uint32_t sid, int status, const cuap_response_t* resp)
+   {
+      static char fn_name[] = "plugin_reply";
+
+      if (status == CUAP_DONE and resp and (resp->command == CUAP_CONTINUE or resp->command == CUAP_END))
+      {
+         pdu.command_id = resp->command;
+         pdu.op_type    = uint8_t(resp->op_type);
+         pdu.content.assign(resp->content.data ? resp->content.data : "", resp->content.size);
+         return;
+      }
+
+      const string& message = status == CUAP_DONE ? cfg.gateway.client.error.invalid_data : cfg.gateway.client.error.could_not_fetch;
+      logging::error(fmt_data_error, fn_name, sid, message);
+      pdu.command_id = pdu::CommandIDs::End;
+      pdu.op_type    = pdu::USSDOperationTypes::USSN;
+      pdu.content    = message;
+   }
+
+   template <command_id request_type = command_id::begin>
+   auto gateway_t::build_http_request(const auto& packet)
+   {
       HttpRequestPtr req = HttpRequest::newHttpRequest();
       req->setMethod(drogon::Get);
       req->setPath("/");
 
-      if constexpr (request_type == command_id::begin)
+      pdu::msisdn_t     msisdn;      // the views in @payload point here
+      pdu::system_id_t  system_id;
+      backend_request_t payload;
+      payload.command = uint32_t(request_type);
+      if constexpr (request_type == command_id::begin or request_type == command_id::continue_)
       {
-         // When command_id = Begin, content is service code. Other times content stays content
-         req->setBody(fmt::format(frmt_begin,
-               command_id::begin, packet.sender_id(), packet.command_len(), packet.msisdn(), packet.ussd_content()
-            )
-         );
-      }
-      else if constexpr (request_type == command_id::continue_)
-      {
-         req->setBody(fmt::format(frmt_begin,
-               command_id::continue_, packet.sender_id(), packet.command_len(), packet.msisdn(), packet.ussd_content()
-            )
-         );
+         payload.sid     = packet.sender_id();
+         payload.length  = packet.command_len();
+         msisdn          = packet.msisdn();
+         payload.msisdn  = msisdn.view();
+         payload.content = packet.ussd_content();
       }
       else if constexpr (request_type == command_id::abort)
       {
-         static char frmt_abort[] = R"({{ "command": {}, "sid": "0x{:08x}", "length": {} }})""\n";
-         req->setBody(fmt::format(frmt_abort,
-               command_id::abort, packet.sender_id(), packet.command_len()
-            )
-         );
+         payload.sid     = packet.sender_id();
+         payload.length  = packet.command_len();
       }
       else if constexpr (request_type == command_id::bind)
       {
-         req->setBody(fmt::format(R"({{ "command": {}, "pdu-status": {}, "length": {}, "system_id": "{}" }})""\n",
-               command_id::bind, packet.command_status(), packet.command_len(), packet.system_id()
-            )
-         );
+         payload.status    = packet.command_status();
+         payload.length    = packet.command_len();
+         system_id         = packet.system_id();
+         payload.system_id = system_id.view();
       }
-      fmt::print("{}. [ gateway::build_http_request info ]: request: {}", misc::current_time(), req->body());
+
+      // Encoded into a buffer of this loop, requests are only built on the loop handling their PDU
+      req->setContentTypeString(codec->content_type());
+      req->setBody(string(codec->encode(payload)));   // one allocation of the exact size
+      logging::debug("[ gateway::build_http_request info ]: {} request, {} bytes\n", codec->name(), req->body().size());
       return req;
    }
 
+   /// Creates the TCP client once, later reconnects reuse it via connect()
    void gateway_t::init()
    {
       tcp_client  = std::make_shared<trantor::TcpClient>(evloop_tcp.getLoop(), addr, "gateway");
       tcp_client->setConnectionCallback([&] (tcp_conn_t conn)  { on_connect(conn); });
       tcp_client->setConnectionErrorCallback([&] { on_conn_error(); });
       tcp_client->setMessageCallback([&] (tcp_conn_t conn, msg_buffer_t msg) { on_message(conn, msg); } );
+      connect();
+   }
+
+   void gateway_t::connect()
+   {
+      set_link_state(link_state_t::connecting);
       tcp_client->connect();
    }
 
+   void gateway_t::schedule_reconnect()
+   {
+      double delay = reconnect.schedule(evloop_tcp.getLoop(), [this] { connect(); });
+      if (delay > 0)
+      {
+         set_link_state(link_state_t::backoff);
+         logging::warn("[ gateway_t::schedule_reconnect info ]: Reconnecting to {} in {:.3f}s (attempt {})\n",
+            addr.toIpPort(), delay, reconnect.attempt
+         );
+      }
+   }
+
+   void gateway_t::set_link_state(link_state_t st)
+   {
+      if (state == st)
+         return;
+
+      logging::info("[ gateway_t::set_link_state info ]: Link {} -> {}\n",
+         link_state_name(state), link_state_name(st)
+      );
+      state = st;
+   }
+
    void gateway_t::send_http_request(HttpRequestPtr& req)
    {
-      http_client->sendRequest(req, [&](ReqResult result, const HttpResponsePtr& response)
+      backend.send(req, [&](ReqResult result, const HttpResponsePtr& response)
       {
          if (result == ReqResult::Ok && response)
          {
-            fmt::print_green("{}. [ gateway::send_http_request info ]: response: {}\n", misc::current_time(), response->getBody());
+            logging::info("[ gateway::send_http_request info ]: response: {}\n", response->getBody());
          }
          else
          {
-            fmt::print_red("{}. [ gateway::send_http_request error ]: request to {} failed\n",
-               misc::current_time(), cfg.gateway.client.url
-            );
+            logging::error("[ gateway::send_http_request error ]: request to {} failed\n", cfg.gateway.client.url);
             /// TODO: Error to be displayed to mobile be defined in config file
          }
       });
@@ -456,7 +638,7 @@ namespace gateway
       if (conn->connected())
       {
          std::string raddr = conn->peerAddr().toIpPort();
-         fmt::print_cyan("{}. [ {}::on_connection info ]: Connected to: {}\n", misc::current_time(), tcp_client->name(), raddr);
+         logging::info("[ {}::on_connection info ]: Connected to: {}\n", tcp_client->name(), raddr);
          setup_bind(cfg, bindmsg);
 
          #ifdef ENABLE_PDU_LOG
@@ -464,117 +646,245 @@ namespace gateway
          #endif
 
          conn->send(bindmsg, bindmsg.capacity());
-         fmt::print_green("{}. [ {}::on_connection info ]: Sent Bind Message to: {}\n", misc::current_time(), tcp_client->name(), raddr);
+         set_link_state(link_state_t::binding);
+         logging::info("[ {}::on_connection info ]: Sent Bind Message to: {}\n", tcp_client->name(), raddr);
       }
       else
       {
-         fmt::print_red("{}. [ gateway::on_connection error ]: Disconnected.\n", misc::current_time());
-         init();
+         logging::error("[ gateway::on_connection error ]: Disconnected.\n");
+         keepalive.stop();
+         workers.each([](worker_t& w) { w.sessions.clear(); });
+         schedule_reconnect();
       }
-      fmt::print(std::flush(std::cout), "");
    }
 
    void gateway_t::on_conn_error()
    {
-      using namespace std::literals;
-
-      fmt::print_red("{}. [ gateway_t::on_conn_error error ]: Connection Lost.\n", current_time());
-      fmt::print(std::flush(std::cout), "");
-      std::this_thread::sleep_for(10s);
-      init();
+      logging::error("[ gateway_t::on_conn_error error ]: Connection Lost.\n");
+      schedule_reconnect();
    }
 
    void gateway_t::on_message(tcp_conn_t conn, msg_buffer_t msg)
    {
-      static std::atomic_int id = 0;
-      if (conn->connected())
+      if (!conn->connected())
       {
-         string_view_t data { msg->peek(), msg->readableBytes() };
-         auto cmd = htobe32(header::command_id(data));
+         logging::error("[ gateway_t::on_message error ]: Not connected\n");
+         msg->retrieveAll();
+         return;
+      }
 
-      #ifdef ENABLE_PDU_LOG
-         //fmt::print_green(fmt_cmdid, cmd, pdu_name(cmd));
-         misc::print_pdu(data.data(), data.size());
-      #endif
+      auto status = pdu::for_each_frame(msg, [&](string_view_t frame) { on_pdu(conn, frame); });
+      if (status == pdu::frame_status::corrupt)
+      {
+         logging::error("[ gateway_t::on_message error ]: Invalid command length {}, dropping connection\n", pdu::frame_len(msg->peek()));
+         msg->retrieveAll();
+         conn->forceClose();
+      }
+   }
+
+   void gateway_t::on_pdu(tcp_conn_t conn, string_view_t data)
+   {
+      pdu::header_t hdr   = pdu::header_view_t(data).header();
+      const auto&   entry = pdu_handlers[hdr.command_id];
+      const auto&   cmd   = *entry.info;
+
+   #ifdef ENABLE_PDU_LOG
+      fmt::print_green(fmt_cmdid, hdr.command_id, cmd.name);
+      misc::print_pdu(data.data(), data.size());
+   #endif
 
-         switch (cmd)
+      if (!cmd.known)
+      {
+         logging::error("[ {}::on_message info ]: Unknown Command 0x{:08x}\n", tcp_client->name(), hdr.command_id);
+         return;
+      }
+      if (!cmd.valid_len(data.size()))
+      {
+         logging::error("[ {}::on_message error ]: {} of {} bytes, expected {}..{}, dropped\n",
+            tcp_client->name(), cmd.name, data.size(), cmd.min_len, cmd.max_len
+         );
+         return;
+      }
+      if (entry.handler)
+         (this->*entry.handler)(conn, data, hdr);
+   }
+
+   void gateway_t::on_bind_resp(tcp_conn_t conn, string_view_t data, const pdu::header_t& hdr)
+   {
+      pdu::bind_resp_view_t bindresp(data);
+      if (hdr.command_status == 0)
+      {
+         logging::info("[ {}::on_message info ]: Bind Successful!\n", tcp_client->name());
+         set_link_state(link_state_t::bound);
+         reconnect.reset();
+         keepalive.start(conn->getLoop(), conn, [wconn = std::weak_ptr<TcpConnection>(conn)]
          {
-            case CommandIDs::BindResp:
-            {
-               pdu::bind_resp_t bindresp(msg->peek(), msg->readableBytes() );
-               bindresp.decode_header();
-               if (bindresp.command_status() == 0)
-               {
-                  fmt::print_green("{}. [ {}::on_message info ]: Bind Successful!\n", misc::current_time(), tcp_client->name());
-               }
-               else
-               {
-                  fmt::print_red("{}. [ {}::on_message error ]: Bind Failed!\n", misc::current_time(), tcp_client->name());
-               }
-               fmt::print(std::flush(std::cout), "");
-               HttpRequestPtr req = build_http_request<command_id::bind>(bindresp);
-               send_http_request(req);
-               msg->retrieveAll();
-            }
-            break;
+            if (auto c = wconn.lock())
+               c->forceClose();
+         });
+      }
+      else
+      {
+         logging::error("[ {}::on_message error ]: Bind Failed!\n", tcp_client->name());
+         conn->forceClose(); // retried with backoff from on_connect
+      }
+      HttpRequestPtr req = build_http_request<command_id::bind>(bindresp);
+      send_http_request(req);
+   }
+
+   /// UssdBindResp can be sent only by the USSDC to the service application.
+   void gateway_t::on_unbind_resp(tcp_conn_t, string_view_t, const pdu::header_t&)
+   {
+      logging::info("[ {}::on_message info ]: UnBind Successful!\n", tcp_client->name());
+   }
+
+   void gateway_t::on_shake(tcp_conn_t conn, string_view_t, const pdu::header_t&)
+   {
+      send::shake_resp(tcp_client, conn);
+   }
+
+   void gateway_t::on_shake_resp(tcp_conn_t, string_view_t, const pdu::header_t&)
+   {
+      keepalive.on_shake_resp();
+   }
+
+   /// Runs on the TCP loop: copies the PDU out of the connection buffer and queues it on the
+   /// worker that owns its dialog, PDUs of one dialog are handled in the order they arrived
+   void gateway_t::dispatch(tcp_conn_t conn, string_view_t data, const pdu::header_t& hdr)
+   {
+      request_ctx_t* ctx = requests.acquire();
+      ctx->load(data);
+      ctx->conn   = conn;
+      ctx->worker = &workers.for_session(hdr.sender_id);
+      ctx->worker->loop->queueInLoop([this, ctx] { on_dialog_pdu(ctx); });
+   }
 
-            case CommandIDs::ShakeResp:
-               send::shake(tcp_client, conn, msg);
-               msg->retrieveAll();
-            break;
+   /// Runs on the dialog's worker loop, the only place its session is touched
+   void gateway_t::on_dialog_pdu(request_ctx_t* ctx)
+   {
+      worker_t&          worker   = *ctx->worker;
+      session_table_t&   sessions = worker.sessions;
+      pdu::begin_view_t  req      = ctx->request();
+      uint32_t           sid      = req.sender_id();
 
-            /// Listens to Begin from USSDC
-            case CommandIDs::Begin:
+      switch (req.command_id())
+      {
+         case CommandIDs::Begin:
+         {
+            pdu::msisdn_key_t msisdn = req.msisdn_key();
+            if (!admit(worker, req, msisdn))
             {
-               continue_msg_t pdu, pdu_req { msg->peek(), msg->readableBytes() };
-               pdu.set_sender_id(++id);
-               build_begin(pdu, pdu_req, [&, tconn = std::move(conn)] {
-                  tconn->send(pdu, pdu.capacity());
-               });
+               requests.release(ctx);
+               break;
             }
-            break;
 
-            /// Listens to Continue from USSDC
-            case CommandIDs::Continue:
+            session_t* session = sessions.open(sid, msisdn, req.service_code());
+            if (!session)
             {
-               continue_msg_t pdu, pdu_req { msg->peek(), msg->readableBytes() };
-               pdu.set_sender_id(id);
-               build_continue(pdu, pdu_req, [&, tconn = std::move(conn)] {
-                  tconn->send(pdu, pdu.capacity());
-               });
-            } break;
-
-            case CommandIDs::End:
-            break;
+               logging::error("[ gateway_t::on_dialog_pdu error ]: Session table of worker {} full ({} dialogs), not serving sid: 0x{:08x}\n",
+                  worker.index, sessions.size(), sid
+               );
+               requests.release(ctx);
+               break;
+            }
+            ctx->pdu.sender_id = session->gateway_id;
+            auto reply = [this, ctx] {
+               send_reply(ctx);
+               close_session_on_end(*ctx->worker, ctx->pdu);
+               requests.release(ctx);
+            };
+            if (const plugin_t* plugin = plugins.find(session->service_code))
+               build_plugin(*plugin, ctx->pdu, req, req.msisdn().view(), session->service_code, worker, reply);
+            else
+               build_begin(ctx->pdu, req, reply);
+         }
+         break;
 
-            case CommandIDs::Abort:
+         case CommandIDs::Continue:
+         {
+            session_t* session = sessions.find(sid);
+            if (!session)
             {
-               abort_msg_t pdu_req { msg->peek(), msg->readableBytes() };
-               build_abort(pdu_req, [&] {
-                  //
-               });
-            } break;
-
-            /// UssdBindResp can be sent only by the USSDC to the service application.
-            case CommandIDs::UnBindResp:
+               // Expired, evicted or never begun: checked like a Begin before it gets a session
+               logging::warn("[ gateway_t::on_dialog_pdu warn ]: Continue for unknown sid: 0x{:08x}, opening a new session\n", sid);
+               pdu::msisdn_key_t msisdn = req.msisdn_key();
+               if (admit(worker, req, msisdn))
+                  session = sessions.open(sid, msisdn, req.service_code());
+               if (!session)
+               {
+                  requests.release(ctx);
+                  break;
+               }
+            }
+            session->touch();
+            ctx->pdu.sender_id = session->gateway_id;
+            auto reply = [this, ctx] {
+               send_reply(ctx);
+               close_session_on_end(*ctx->worker, ctx->pdu);
+               requests.release(ctx);
+            };
+            if (const plugin_t* plugin = plugins.find(session->service_code))
+               build_plugin(*plugin, ctx->pdu, req, req.msisdn().view(), session->service_code, worker, reply);
+            else
+               build_continue(ctx->pdu, req, reply);
+         }
+         break;
+
+         case CommandIDs::Abort:
+         {
+            // An Abort carries no service code, the session knows whose dialog it was. Without one
+            // nobody can tell: it expired, was evicted or never passed admit(), so it goes nowhere.
+            session_t* session = sessions.find(sid);
+            if (!session)
             {
-               msg->retrieveAll();
-               fmt::print_green("{}. [ {}::on_message info ]: UnBind Successful!\n", misc::current_time(), tcp_client->name());
-            } break;
+               logging::warn("[ gateway_t::on_dialog_pdu warn ]: Abort for unknown sid: 0x{:08x}, dropped\n", sid);
+               requests.release(ctx);
+               break;
+            }
 
-            default:
+            const plugin_t*     plugin = plugins.find(session->service_code);
+            pdu::service_code_t service_code;
+            pdu::msisdn_t       msisdn;
+            if (plugin)
             {
-               fmt::print_red("{}. [ {}::on_message info ]: Unknown Command\n", misc::current_time(), tcp_client->name());
-               msg->retrieveAll();
+               service_code = session->service_code;
+               msisdn       = session->msisdn.str().view();
             }
+            sessions.erase(sid);
+
+            auto release = [this, ctx] { requests.release(ctx); };
+            if (plugin)
+               build_plugin(*plugin, ctx->pdu, req, msisdn.view(), service_code, worker, release);
+            else
+               build_abort(req, release);
          }
+         break;
+
+         default:
+            requests.release(ctx);
       }
-      else
-      {
-         fmt::print_red("{}. [ gateway_t::on_message error ]: Not connected\n", current_time());
-      }
-      fmt::print(std::flush(std::cout), "");
-      msg->retrieveAll();
+   }
+
+   /// Encodes the reply at its exact length and sends only those bytes
+   void gateway_t::send_reply(request_ctx_t* ctx)
+   {
+      size_t len = pdu::encode_to(ctx->out, ctx->pdu);
+
+      #ifdef ENABLE_PDU_LOG
+         misc::print_pdu(ctx->out.peek(), len);
+      #endif
+      ctx->conn->send(ctx->out.peek(), len);
+      ctx->out.retrieve(len);
+   }
+
+   /// Called from the HTTP loop once a response went out, the session is erased on its own worker
+   void gateway_t::close_session_on_end(worker_t& worker, const pdu::end_fields_t& pdu)
+   {
+      if (pdu.command_id != CommandIDs::End)
+         return;
+
+      uint32_t sid = pdu.receiver_id;
+      worker.loop->runInLoop([w = &worker, sid] { w->sessions.erase(sid); });
    }
 
    void gateway_t::setup_config()
@@ -583,44 +893,92 @@ namespace gateway
       {
          cfg.read_then_parse<config::config_type::json>(cli_cfg.config);
          addr        = InetAddress(cfg.gateway.host, cfg.gateway.port);
-         http_client = HttpClient::newHttpClient(cfg.gateway.client.url, evloop_http.getLoop());
          cli_cfg.rurl= cfg.gateway.client.url;
       }
       else
       {
          addr = InetAddress(cli_cfg.chost, cli_cfg.cport);
-         http_client = HttpClient::newHttpClient(cli_cfg.rurl, evloop_http.getLoop());
+         cfg.app.threads                = cli_cfg.threads;
+         cfg.gateway.client.connections = cli_cfg.num_conns;
+         cfg.gateway.client.timeout     = cli_cfg.timeout;
       }
+
+      keepalive.interval   = cfg.gateway.shake_interval;
+      keepalive.max_missed = cfg.gateway.shake_max_missed;
+      reconnect.min_delay  = cfg.gateway.reconnect_min_ms / 1000.0;
+      reconnect.max_delay  = cfg.gateway.reconnect_max_ms / 1000.0;
+
+      auto& client = cfg.gateway.client;
+      backend.max_outstanding = client.max_outstanding;
+      backend.idle_timeout    = client.keepalive_timeout;
+      backend.timeout         = client.timeout;
+      backend.start(cli_cfg.rurl, client.connections, client.loops);
+      setup_data_transfer_mode();
    }
 
    void gateway_t::setup_data_transfer_mode()
    {
-      string md = cfg["data-transfer-mode"].asString();
-      if (md == "xml")
+      const string& mode = cfg.gateway.client.data_transfer_mode;
+      codec = make_codec(mode);
+      if (!codec)
       {
-         data_transfer_mode = data_transfer_mode_t::xml;
-         format::req_cont = R"(<continue>
-   <sid>{}</sid>
-   <rid>{}</rid>
-   <service_code>{}</service_code>
-   <operation>{}</operation>
-   <msisdn>{}</msisdn>
-   <content>{}</content>
-</continue>)";
+         logging::error("[ gateway_t::setup_data_transfer_mode error ]: unknown data-transfer-mode '{}', expected json | msgpack | xml\n", mode);
+         exit(-1);
       }
+      logging::info("[ gateway_t::setup_data_transfer_mode info ]: backend speaks {}\n", codec->name());
+   }
 
+   /// Loads the plugins of gateway.plugins, before any dialog can reach them
+   void gateway_t::load_plugins()
+   {
+      for (const auto& p : cfg.gateway.plugins)
+      {
+         if (!plugins.add(p.service_code, p.library, p.config))
+         {
+            logging::error("[ gateway_t::load_plugins error ]: plugin for service code '{}' not loaded, exiting\n", p.service_code);
+            exit(-1);
+         }
+      }
    }
 
    void gateway_t::run()
    {
       Logger::setLogLevel(Logger::LogLevel::kError);
       setup_config();
+      logging::set_level(logging::level_from_name(cfg.app.log_level));
       setup_bind(cfg, bindmsg);
-      build_whitelist();
+      load_plugins();
+      workers.start(cfg.app.threads, cfg.gateway.max_sessions);
+      reload_admission();
+
+      std::vector<string> admission_files;
+      for (const string& file : { cfg.gateway.white_list, cfg.gateway.number_rules })
+      {
+         if (!file.empty())
+            admission_files.push_back(file);
+      }
+      if (!admission_files.empty())
+         white_list_watcher.start(admission_files, cfg.gateway.white_list_watch, [this] { reload_admission(); });
+      logging::info("[ gateway_t::run info ]: {} worker loop(s), {} backend connection(s) on {} loop(s)\n",
+         workers.size(), backend.size(), cfg.gateway.client.loops
+      );
       init();
 
+      workers.each([this](worker_t& w)
+      {
+         w.loop->runEvery(10.0, [this, &w]
+         {
+            size_t dropped = w.sessions.expire(std::chrono::seconds(cfg.gateway.session_timeout));
+            if (dropped)
+            {
+               logging::warn("[ gateway_t::run info ]: worker {}: {} idle session(s) expired, {} live\n",
+                  w.index, dropped, w.sessions.size()
+               );
+            }
+         });
+      });
+
       evloop_tcp.run();
-      evloop_http.run();
       evloop_tcp.wait();
    }
 
@@ -0,0 +1,89 @@
+#ifndef http_pool_h
+#define http_pool_h
+
+#include <memory>
+#include <mutex>
+
+#include <drogon/HttpClient.h>
+#include <trantor/net/EventLoopThreadPool.h>
+
+#include "balanced_conns.h"
+#include "logger.h"
+
+//! HTTP backend connection pool
+
+namespace gateway
+{
+   /// @brief N persistent (keep-alive) connections to the HTTP backend spread over several loops,
+   /// balanced and limited by balanced_conns_t. A connection idle for @idle_timeout seconds is closed
+   /// and reopened on its next use, so we never send on a socket the backend already dropped.
+   struct http_pool_t
+   {
+      struct conn_t : conn_load_t
+      {
+         std::mutex            mtx;      ///< guards client, which is dropped when idle
+         drogon::HttpClientPtr client;   ///< made on first use
+      };
+
+      void start(const string& backend_url, size_t nconns, size_t nloops)
+      {
+         url   = backend_url;
+         loops = std::make_unique<trantor::EventLoopThreadPool>(std::max<size_t>(nloops, 1), "eventloop.thread.http");
+         loops->start();
+         conns.start(nconns, *loops, idle_timeout, [this](conn_t& c) { close_if_idle(c); });
+      }
+
+      /// Sends @req on the least loaded connection, @cb runs on that connection's loop.
+      /// When every connection is at @max_outstanding @cb runs at once with ReqResult::NetworkFailure.
+      void send(const drogon::HttpRequestPtr& req, drogon::HttpReqCallback cb)
+      {
+         conn_t* c = conns.acquire(max_outstanding);
+         if (!c)
+         {
+            logging::warn("[ http_pool_t::send warn ]: All {} backend connection(s) at {} outstanding request(s)\n",
+               conns.size(), max_outstanding
+            );
+            cb(drogon::ReqResult::NetworkFailure, nullptr);
+            return;
+         }
+
+         drogon::HttpClientPtr client;
+         {
+            std::lock_guard<std::mutex> lock(c->mtx);
+            if (!c->client)
+               c->client = drogon::HttpClient::newHttpClient(url, c->loop);
+            client = c->client;
+         }
+
+         client->sendRequest(req, [c, cb = std::move(cb)](drogon::ReqResult result, const drogon::HttpResponsePtr& response)
+         {
+            balanced_conns_t<conn_t>::release(*c);
+            cb(result, response);
+         }, timeout);
+      }
+
+      size_t outstanding() const { return conns.outstanding(); }
+      size_t size() const        { return conns.size(); }
+
+      uint32_t max_outstanding = 64;
+      double   idle_timeout    = 60;  ///< seconds
+      double   timeout         = 5;   ///< seconds per request
+
+   private:
+      /// Runs on @c's loop
+      void close_if_idle(conn_t& c)
+      {
+         if (!c.idle_for(idle_timeout))
+            return;
+
+         std::lock_guard<std::mutex> lock(c.mtx);
+         c.client.reset();
+      }
+
+      string url;
+      std::unique_ptr<trantor::EventLoopThreadPool> loops;
+      balanced_conns_t<conn_t> conns;
+   };
+}
+
+#endif//http_pool_h
@@ -0,0 +1,254 @@
+#ifndef json_reader_h
+#define json_reader_h
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+
+#include "codec.h"
+
+//! @brief One pass decoder for the backend's response
+/** The response is a flat object; only "command", "op_type", "msisdn", "content" and whether there
+    is a "system_id" matter. They're picked out in a single scan, strings as views into the body, or
+    into a buffer the reader keeps when they hold escapes. Other plain members are skipped. <br>
+    Anything this doesn't expect, e.g. nested values or a number that isn't an unsigned integer
+    where one is needed, gets status_t::fallback: the caller then parses the body as a full DOM.
+*/
+
+namespace gateway
+{
+   struct json_reader_t
+   {
+      enum class status_t { ok, fallback, invalid };
+
+      /// @out's views stay valid until the next read() or until @body goes
+      status_t read(string_view_t body, backend_response_t& out)
+      {
+         out = {};
+         p   = body.data();
+         end = p + body.size();
+         used_msisdn = used_content = false;
+
+         if (!expect('{'))
+            return status_t::invalid;
+         if (expect('}'))
+            return status_t::ok;
+
+         for (;;)
+         {
+            string_view_t key;
+            if (peek() != '"' or !raw_string(key) or !expect(':'))
+               return status_t::invalid;
+            if (key.find('\\') != string_view_t::npos)
+               return status_t::fallback;
+
+            skip_ws();
+            status_t s = status_t::ok;
+            if (key == "command")
+               s = number(out.command, out.has_command);
+            else if (key == "op_type")
+               s = number(out.op_type, out.has_op_type);
+            else if (key == "msisdn")
+               s = text(out.msisdn, out.has_msisdn, msisdn_buf, used_msisdn);
+            else if (key == "content")
+               s = text(out.content, out.has_content, content_buf, used_content);
+            else
+            {
+               out.has_system_id |= key == "system_id";
+               s = skip_value();
+            }
+            if (s != status_t::ok)
+               return s;
+
+            skip_ws();
+            if (p < end and *p == ',')
+            {
+               ++p;
+               skip_ws();
+               continue;
+            }
+            return expect('}') ? status_t::ok : status_t::invalid;
+         }
+      }
+
+   private:
+      void skip_ws()
+      {
+         while (p < end and (*p == ' ' or *p == '\n' or *p == '\r' or *p == '\t'))
+            ++p;
+      }
+
+      char peek()
+      {
+         skip_ws();
+         return p < end ? *p : '\0';
+      }
+
+      bool expect(char c)
+      {
+         if (peek() != c)
+            return false;
+         ++p;
+         return true;
+      }
+
+      /// The bytes between the quotes at @p, escapes left in; memchr finds both candidates for the end
+      bool raw_string(string_view_t& s)
+      {
+         const char* b = ++p;
+         for (;;)
+         {
+            auto* q = static_cast<const char*>(memchr(p, '"', size_t(end - p)));
+            if (!q)
+               return false;
+
+            size_t bs = 0;   // an odd run of backslashes escapes the quote
+            for (const char* r = q; r > b and r[-1] == '\\'; --r)
+               ++bs;
+            p = q + 1;
+            if (bs % 2 == 0)
+            {
+               s = { b, size_t(q - b) };
+               return true;
+            }
+         }
+      }
+
+      status_t number(uint32_t& v, bool& has)
+      {
+         auto r = std::from_chars(p, end, v);
+         if (r.ec != std::errc() or (r.ptr < end and (*r.ptr == '.' or *r.ptr == 'e' or *r.ptr == 'E')))
+            return status_t::fallback;   // negative, too big, a float or a string: the DOM decides
+         p   = r.ptr;
+         has = true;
+         return status_t::ok;
+      }
+
+      status_t text(string_view_t& v, bool& has, std::string& buf, bool& used)
+      {
+         if (p >= end or *p != '"')
+            return status_t::fallback;
+         if (!raw_string(v))
+            return status_t::invalid;
+
+         if (v.find('\\') != string_view_t::npos)
+         {
+            if (used or !unescape(v, buf))
+               return status_t::fallback;   // a duplicate member, or an escape that isn't JSON
+            used = true;
+            v    = buf;
+         }
+         has = true;
+         return status_t::ok;
+      }
+
+      /// Strings, numbers, true, false and null; objects and arrays are left to the DOM
+      status_t skip_value()
+      {
+         if (p >= end)
+            return status_t::invalid;
+         if (*p == '"')
+         {
+            string_view_t ignored;
+            return raw_string(ignored) ? status_t::ok : status_t::invalid;
+         }
+         if (*p == '{' or *p == '[')
+            return status_t::fallback;
+
+         const char* b = p;
+         while (p < end and *p != ',' and *p != '}' and *p != ' ' and *p != '\n' and *p != '\r' and *p != '\t')
+            ++p;
+         return p > b ? status_t::ok : status_t::invalid;
+      }
+
+      static bool unescape(string_view_t in, std::string& out)
+      {
+         out.clear();
+         for (size_t i = 0; i < in.size(); ++i)
+         {
+            if (in[i] != '\\')
+            {
+               size_t n = in.find('\\', i);
+               n = n == string_view_t::npos ? in.size() : n;
+               out.append(in.data() + i, n - i);
+               i = n - 1;
+               continue;
+            }
+            if (++i >= in.size())
+               return false;
+
+            switch (in[i])
+            {
+               case '"':  out += '"';  break;
+               case '\\': out += '\\'; break;
+               case '/':  out += '/';  break;
+               case 'b':  out += '\b'; break;
+               case 'f':  out += '\f'; break;
+               case 'n':  out += '\n'; break;
+               case 'r':  out += '\r'; break;
+               case 't':  out += '\t'; break;
+               case 'u':
+               {
+                  uint32_t cp;
+                  if (!hex4(in, i + 1, cp))
+                     return false;
+                  i += 4;
+                  if (cp >= 0xD800 and cp < 0xDC00)   // high surrogate, the low one must follow
+                  {
+                     uint32_t lo;
+                     if (i + 2 >= in.size() or in[i + 1] != '\\' or in[i + 2] != 'u' or !hex4(in, i + 3, lo) or lo < 0xDC00 or lo > 0xDFFF)
+                        return false;
+                     cp  = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                     i  += 6;
+                  }
+                  utf8(cp, out);
+               }
+               break;
+
+               default:
+                  return false;
+            }
+         }
+         return true;
+      }
+
+      static bool hex4(string_view_t in, size_t at, uint32_t& v)
+      {
+         if (at + 4 > in.size())
+            return false;
+         auto r = std::from_chars(in.data() + at, in.data() + at + 4, v, 16);
+         return r.ec == std::errc() and r.ptr == in.data() + at + 4;
+      }
+
+      static void utf8(uint32_t cp, std::string& out)
+      {
+         if (cp < 0x80)
+            out += char(cp);
+         else if (cp < 0x800)
+         {
+            out += char(0xC0 | (cp >> 6));
+            out += char(0x80 | (cp & 0x3F));
+         }
+         else if (cp < 0x10000)
+         {
+            out += char(0xE0 | (cp >> 12));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+         }
+         else
+         {
+            out += char(0xF0 | (cp >> 18));
+            out += char(0x80 | ((cp >> 12) & 0x3F));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+         }
+      }
+
+      const char* p   = nullptr;
+      const char* end = nullptr;
+      std::string msisdn_buf, content_buf;   ///< unescaped strings, kept between reads
+      bool        used_msisdn = false, used_content = false;
+   };
+}
+
+#endif//json_reader_h
@@ -0,0 +1,172 @@
+#ifndef json_writer_h
+#define json_writer_h
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#if defined(__SSE2__)
+   #include <emmintrin.h>
+#endif
+
+#include "pdu/fixed_string.h"
+
+//! @brief JSON writer for the backend payloads
+/** Appends straight into one buffer that is cleared, never freed, between payloads, so a warmed up
+    writer doesn't allocate. Strings are escaped: runs of plain bytes are found 16 at a time (SSE2)
+    and copied in one go, only '"', '\\' and control characters take the slow path. Bytes >= 0x80
+    are copied as they are, the USSD content is expected to be UTF-8 already. <br>
+    Numbers go through std::to_chars, hex ids through a 256 entry table of digit pairs.
+*/
+
+namespace gateway
+{
+   struct json_writer_t
+   {
+      /// Starts a new payload, keeps the capacity
+      json_writer_t& clear()
+      {
+         buf.clear();
+         first = true;
+         return *this;
+      }
+
+      json_writer_t& begin_object() { buf += "{ "; first = true; return *this; }
+      json_writer_t& end_object()   { buf += " }\n"; return *this; }
+
+      template <class T>
+      json_writer_t& field(string_view_t name, T v) requires std::is_integral_v<T>
+      {
+         key(name);
+         char  tmp[24];
+         auto  r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+         buf.append(tmp, size_t(r.ptr - tmp));
+         return *this;
+      }
+
+      json_writer_t& field(string_view_t name, string_view_t v)
+      {
+         key(name);
+         quoted(v);
+         return *this;
+      }
+
+      /// "0x%08x"
+      json_writer_t& field_hex(string_view_t name, uint32_t v)
+      {
+         key(name);
+         char out[12] = { '"', '0', 'x' };
+         for (int i = 0; i < 4; ++i)
+            memcpy(out + 3 + 2 * i, hex_pairs().table[(v >> (24 - 8 * i)) & 0xFF], 2);
+         out[11] = '"';
+         buf.append(out, sizeof(out));
+         return *this;
+      }
+
+      /// A quoted, escaped string
+      json_writer_t& quoted(string_view_t s)
+      {
+         buf.reserve(buf.size() + s.size() + 2);
+         buf += '"';
+
+         const char* p   = s.data();
+         const char* end = p + s.size();
+         while (p < end)
+         {
+            const char* run = plain_run(p, end);
+            buf.append(p, size_t(run - p));
+            if (run == end)
+               break;
+            escape(*run);
+            p = run + 1;
+         }
+
+         buf += '"';
+         return *this;
+      }
+
+      string_view_t view() const { return buf; }
+      size_t        size() const { return buf.size(); }
+
+   private:
+      void key(string_view_t name)
+      {
+         if (!first)
+            buf += ", ";
+         first = false;
+         buf += '"';
+         buf += name;
+         buf += "\": ";
+      }
+
+      static bool needs_escape(char c) { return uint8_t(c) < 0x20 or c == '"' or c == '\\'; }
+
+      /// First byte in [@p, @end) that needs escaping, or @end
+      static const char* plain_run(const char* p, const char* end)
+      {
+      #if defined(__SSE2__)
+         const __m128i quote = _mm_set1_epi8('"'), bslash = _mm_set1_epi8('\\'), ctl_max = _mm_set1_epi8(0x1F);
+         for (; end - p >= 16; p += 16)
+         {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            // bytes < 0x20, compared unsigned: min(v, 0x1F) == v
+            __m128i ctl  = _mm_cmpeq_epi8(_mm_min_epu8(v, ctl_max), v);
+            __m128i hit  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash)), ctl);
+            int     mask = _mm_movemask_epi8(hit);
+            if (mask)
+               return p + __builtin_ctz(unsigned(mask));
+         }
+      #endif
+         while (p < end and !needs_escape(*p))
+            ++p;
+         return p;
+      }
+
+      void escape(char c)
+      {
+         switch (c)
+         {
+            case '"':  buf += "\\\""; break;
+            case '\\': buf += "\\\\"; break;
+            case '\n': buf += "\\n";  break;
+            case '\r': buf += "\\r";  break;
+            case '\t': buf += "\\t";  break;
+            case '\b': buf += "\\b";  break;
+            case '\f': buf += "\\f";  break;
+            default:
+            {
+               char u[6] = { '\\', 'u', '0', '0' };
+               memcpy(u + 4, hex_pairs().table[uint8_t(c)], 2);
+               buf.append(u, sizeof(u));
+            }
+         }
+      }
+
+      struct hex_table_t
+      {
+         char table[256][2];
+
+         constexpr hex_table_t() : table {}
+         {
+            constexpr char digits[] = "0123456789abcdef";
+            for (int i = 0; i < 256; ++i)
+            {
+               table[i][0] = digits[i >> 4];
+               table[i][1] = digits[i & 0xF];
+            }
+         }
+      };
+
+      static const hex_table_t& hex_pairs()
+      {
+         static constexpr hex_table_t t;
+         return t;
+      }
+
+      std::string buf;
+      bool        first = true;
+   };
+}
+
+#endif//json_writer_h
@@ -0,0 +1,107 @@
+#ifndef keepalive_h
+#define keepalive_h
+
+#include <chrono>
+#include <functional>
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/net/TcpConnection.h>
+
+#include "pdu/pdu.h"
+#include "logger.h"
+
+//! Keepalive: Shake/ShakeResp heartbeat driven by event loop timers
+
+namespace gateway
+{
+   /// @brief Sends a Shake every @interval seconds on the link's own loop and never blocks it.
+   /// Each ShakeResp clears the missed count and records the round-trip time,
+   /// @max_missed Shakes in a row without a ShakeResp declares the link dead.
+   struct keepalive_t
+   {
+      using clock_t = std::chrono::steady_clock;
+
+      /// Arms the timer, must be called on @loop's thread.
+      /// @on_dead runs on @loop once the link is declared dead, the timer is stopped by then.
+      void start(trantor::EventLoop* evloop, const trantor::TcpConnectionPtr& conn, std::function<void()> on_dead)
+      {
+         stop();
+         loop    = evloop;
+         missed  = 0;
+         in_flight = false;
+         dead_fn = std::move(on_dead);
+
+         std::weak_ptr<trantor::TcpConnection> wconn = conn;
+         timer = loop->runEvery(interval, [this, wconn] { tick(wconn); });
+         armed = true;
+      }
+
+      void stop()
+      {
+         if (armed)
+         {
+            loop->invalidateTimer(timer);
+            armed = false;
+         }
+      }
+
+      void on_shake_resp()
+      {
+         if (in_flight)
+         {
+            rtt = std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - sent_at);
+            in_flight = false;
+         }
+         missed = 0;
+      #ifdef ENABLE_PDU_LOG
+         logging::debug("[ keepalive_t::on_shake_resp info ]: ShakeResp, rtt: {}us\n", rtt.count());
+      #endif
+      }
+
+      double interval   = 30; ///< seconds between Shakes
+      uint   max_missed = 3;
+
+      std::chrono::microseconds rtt {0}; ///< last measured Shake -> ShakeResp round trip
+
+   private:
+      void tick(const std::weak_ptr<trantor::TcpConnection>& wconn)
+      {
+         auto conn = wconn.lock();
+         if (!conn or !conn->connected())
+         {
+            stop();
+            return;
+         }
+
+         if (in_flight and ++missed >= max_missed)
+         {
+            logging::error("[ keepalive_t::tick error ]: {} Shake(s) unanswered, link to {} is dead\n",
+               missed, conn->peerAddr().toIpPort()
+            );
+            stop();
+            if (dead_fn)
+               dead_fn();
+            return;
+         }
+
+         conn->send(shake, shake.capacity());
+         sent_at   = clock_t::now();
+         in_flight = true;
+      #ifdef ENABLE_PDU_LOG
+         logging::debug("[ keepalive_t::tick info ]: Sent Shake Message to: {}\n",
+            conn->peerAddr().toIpPort()
+         );
+      #endif
+      }
+
+      cuap::pdu::shake_msg_t shake;   ///< encoded once, header is constant
+      trantor::EventLoop*    loop = nullptr;
+      trantor::TimerId       timer {};
+      bool                   armed = false, in_flight = false;
+      uint                   missed = 0;
+      clock_t::time_point    sent_at;
+      std::function<void()>  dead_fn;
+   };
+}
+
+#endif//keepalive_h
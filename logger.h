@@ -0,0 +1,366 @@
+#ifndef logger_h
+#define logger_h
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <thread>
+
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "fmt-5.h"
+#include "pdu/types.h"
+
+//! Asynchronous logging
+/** Producers format into a slot of their own thread's ring, no locks, no allocation, no syscalls.
+    A single writer thread stamps each record with a cached timestamp and hands batches to writev(2). <br>
+    A thread's ring is handed back when it exits and taken over by the next thread that logs, so
+    short-lived threads don't use up the rings. Threads beyond MAX_THREADS alive at once share one
+    more ring behind a mutex.
+*/
+
+namespace logging
+{
+   enum class level_t : uint8_t { debug, info, warn, error, off };
+
+   inline level_t level_from_name(string_view_t name)
+   {
+      if (name == "debug") return level_t::debug;
+      if (name == "warn")  return level_t::warn;
+      if (name == "error") return level_t::error;
+      if (name == "off")   return level_t::off;
+      return level_t::info;
+   }
+
+   struct record_t
+   {
+      static constexpr uint16_t SIZE   = 512;
+      static constexpr uint16_t PREFIX = 32; ///< room for colour + "YYYY-mm-dd HH:MM:SS. "
+      static constexpr uint16_t SUFFIX = 4;  ///< room for colour reset
+      static constexpr uint16_t MAX_TEXT = SIZE - PREFIX - SUFFIX;
+
+      std::time_t time;
+      level_t     level;
+      uint16_t    len;
+      char        line[SIZE]; ///< text starts at line + PREFIX
+   };
+
+   /// Single producer, single consumer ring of records
+   struct ring_t
+   {
+      static constexpr uint32_t SIZE = 1024; // power of 2
+
+      record_t* reserve()
+      {
+         uint32_t h = head.load(std::memory_order_relaxed);
+         if (h - tail.load(std::memory_order_acquire) == SIZE)
+         {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+         }
+         return &slots[h & (SIZE - 1)];
+      }
+
+      void commit() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+      record_t& at(uint32_t i) { return slots[i & (SIZE - 1)]; }
+
+      uint32_t pending() const
+      {
+         return head.load(std::memory_order_relaxed) - tail.load(std::memory_order_relaxed);
+      }
+
+      std::array<record_t, SIZE> slots;
+      alignas(64) std::atomic<uint32_t> head {0};   ///< written by the producer
+      alignas(64) std::atomic<uint32_t> tail {0};   ///< written by the writer
+      std::atomic<uint64_t> dropped {0};
+      std::atomic<bool>     owned   {true};   ///< false once its thread exited, free to take over
+   };
+
+   class logger_t
+   {
+      public:
+         static constexpr uint32_t MAX_THREADS = 128;
+         static constexpr int      BATCH       = 256; ///< records per writev, below IOV_MAX
+
+         static logger_t& instance()
+         {
+            static logger_t logger;
+            return logger;
+         }
+
+         void set_level(level_t lvl) { min_level.store(lvl, std::memory_order_relaxed); }
+         level_t level() const       { return min_level.load(std::memory_order_relaxed); }
+         bool enabled(level_t lvl) const { return lvl >= level(); }
+
+         template <class ...Args>
+         void write(level_t lvl, string_view_t frmt, const Args&... args)
+         {
+            if (ring_t* ring = local_ring())
+            {
+               put(*ring, lvl, frmt, args...);
+               return;
+            }
+            std::lock_guard<std::mutex> lock(shared_mtx);
+            put(shared, lvl, frmt, args...);
+         }
+
+         /// Blocks until everything logged so far has been written
+         void flush()
+         {
+            std::unique_lock<std::mutex> lock(mtx);
+            uint64_t target = ++flush_req;
+            cv.notify_one();
+            cv.wait(lock, [&] { return flush_done >= target; });
+         }
+
+         ~logger_t()
+         {
+            stop.store(true, std::memory_order_release);
+            cv.notify_one();
+            writer.join();
+         }
+
+      private:
+         logger_t() : colour(::isatty(STDOUT_FILENO)), writer([this] { run(); }) {}
+
+         template <class ...Args>
+         void put(ring_t& ring, level_t lvl, string_view_t frmt, const Args&... args)
+         {
+            record_t* rec = ring.reserve();
+            if (!rec)
+               return;
+
+         #if FMT_VERSION >= 80000
+            auto res = fmt::format_to_n(rec->line + record_t::PREFIX, record_t::MAX_TEXT, fmt::runtime(frmt), args...);
+         #else
+            auto res = fmt::format_to_n(rec->line + record_t::PREFIX, record_t::MAX_TEXT, frmt, args...);
+         #endif
+            rec->len   = std::min<size_t>(res.size, record_t::MAX_TEXT);
+            rec->level = lvl;
+            rec->time  = std::time(nullptr);
+            ring.commit();
+
+            if (ring.pending() >= ring_t::SIZE / 2 and !wake.exchange(true, std::memory_order_relaxed))
+               cv.notify_one();   // burst, don't wait for the writer's next poll
+         }
+
+         /// Gives the thread's ring back when the thread exits
+         struct ring_holder_t
+         {
+            ring_t* ring = nullptr;
+            ~ring_holder_t()
+            {
+               if (ring)
+                  ring->owned.store(false, std::memory_order_release);
+            }
+         };
+
+         /// First call from a thread takes over a ring an exited thread gave back, or registers a new one.
+         /// Rings live as long as the logger. @return nullptr when MAX_THREADS threads hold one: use @shared
+         ring_t* local_ring()
+         {
+            thread_local ring_holder_t holder;
+            if (holder.ring)
+               return holder.ring;
+
+            uint32_t count = std::min(nrings.load(std::memory_order_acquire), MAX_THREADS);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+               ring_t* ring  = rings[i].load(std::memory_order_acquire);
+               bool    freed = false;
+               if (ring and ring->owned.compare_exchange_strong(freed, true, std::memory_order_acq_rel))
+                  return holder.ring = ring;   // the writer may still drain it, a single producer at a time is all it needs
+            }
+
+            uint32_t idx = nrings.load(std::memory_order_relaxed);
+            do
+            {
+               if (idx >= MAX_THREADS)
+                  return nullptr;
+            } while (!nrings.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed));
+
+            holder.ring = new ring_t;
+            rings[idx].store(holder.ring, std::memory_order_release);
+            return holder.ring;
+         }
+
+         void run()
+         {
+            for (;;)
+            {
+               bool stopping = stop.load(std::memory_order_acquire);
+               uint64_t flush_seen;
+               {
+                  std::lock_guard<std::mutex> lock(mtx);
+                  flush_seen = flush_req;
+               }
+
+               size_t written = drain();
+               if (flush_seen != flush_done)
+               {
+                  std::lock_guard<std::mutex> lock(mtx);
+                  flush_done = flush_seen;
+                  cv.notify_all();
+               }
+
+               if (written == 0)
+               {
+                  if (stopping)
+                     break;
+                  std::unique_lock<std::mutex> lock(mtx);
+                  cv.wait_for(lock, std::chrono::milliseconds(2), [&] {
+                     return stop.load(std::memory_order_relaxed) or flush_req != flush_done or
+                            wake.exchange(false, std::memory_order_relaxed);
+                  });
+               }
+            }
+         }
+
+         size_t drain()
+         {
+            size_t   total = 0;
+            uint32_t count = std::min(nrings.load(std::memory_order_acquire), MAX_THREADS);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+               if (ring_t* ring = rings[i].load(std::memory_order_acquire))
+                  total += drain(*ring);
+            }
+            return total + drain(shared);
+         }
+
+         size_t drain(ring_t& ring)
+         {
+            report_dropped(ring);
+
+            size_t   total = 0;
+            uint32_t t = ring.tail.load(std::memory_order_relaxed);
+            uint32_t h = ring.head.load(std::memory_order_acquire);
+            while (t != h)
+            {
+               int cnt = 0;
+               for (; t != h and cnt < BATCH; ++t)
+                  iov[cnt++] = prepare(ring.at(t));
+
+               write_all(iov.data(), cnt);
+               ring.tail.store(t, std::memory_order_release);
+               total += cnt;
+            }
+            return total;
+         }
+
+         /// Writes colour + timestamp in front of the text and the reset after it, in place
+         iovec prepare(record_t& rec)
+         {
+            static constexpr const char* colours[] = { "", "\x1b[32m", "\x1b[33m", "\x1b[31m", "" };
+
+            if (rec.time != cached_time)
+            {
+               std::tm tm;
+               ::localtime_r(&rec.time, &tm);
+               std::strftime(cached_ts, sizeof(cached_ts), "%Y-%m-%d %H:%M:%S", &tm);
+               cached_time = rec.time;
+            }
+
+            const char* clr  = colour ? colours[static_cast<int>(rec.level)] : "";
+            size_t      clen = strlen(clr);
+            char*       text = rec.line + record_t::PREFIX;
+            char*       b    = text - 2;
+            memcpy(b, ". ", 2);
+            b -= 19;
+            memcpy(b, cached_ts, 19);
+            b -= clen;
+            memcpy(b, clr, clen);
+
+            char* e = text + rec.len;
+            if (rec.len == record_t::MAX_TEXT)
+               e[-1] = '\n';   // truncated
+            if (clen)
+            {
+               memcpy(e, "\x1b[0m", 4);
+               e += 4;
+            }
+            return iovec { b, size_t(e - b) };
+         }
+
+         void report_dropped(ring_t& ring)
+         {
+            uint64_t n = ring.dropped.exchange(0, std::memory_order_relaxed);
+            if (n == 0)
+               return;
+
+            char line[96];
+            auto res = fmt::format_to_n(line, sizeof(line), "[ logging::logger_t warn ]: {} record(s) dropped, ring full\n", n);
+            iovec v { line, std::min<size_t>(res.size, sizeof(line)) };
+            write_all(&v, 1);
+         }
+
+         static void write_all(iovec* v, int cnt)
+         {
+            while (cnt > 0)
+            {
+               ssize_t n = ::writev(STDOUT_FILENO, v, cnt);
+               if (n < 0)
+               {
+                  if (errno == EINTR)
+                     continue;
+                  return;
+               }
+               for (; cnt > 0 and size_t(n) >= v->iov_len; ++v, --cnt)
+                  n -= v->iov_len;
+               if (cnt > 0)
+               {
+                  v->iov_base = static_cast<char*>(v->iov_base) + n;
+                  v->iov_len -= n;
+               }
+            }
+         }
+
+         std::atomic<level_t>  min_level { level_t::info };
+         std::atomic<uint32_t> nrings {0};
+         std::array<std::atomic<ring_t*>, MAX_THREADS> rings {};
+         ring_t      shared;       ///< for threads past MAX_THREADS, producers serialised by @shared_mtx
+         std::mutex  shared_mtx;
+
+         std::array<iovec, BATCH> iov;
+         std::time_t cached_time = -1;
+         char        cached_ts[20] {0};
+         bool        colour;
+
+         std::mutex              mtx;
+         std::condition_variable cv;
+         uint64_t                flush_req = 0, flush_done = 0;
+         std::atomic<bool>       stop {false}, wake {false};
+         std::thread             writer;
+   };
+
+   inline void set_level(level_t lvl)  { logger_t::instance().set_level(lvl); }
+   inline bool enabled(level_t lvl)    { return logger_t::instance().enabled(lvl); }
+   inline void flush()                 { logger_t::instance().flush(); }
+
+   template <class ...Args>
+   inline void log(level_t lvl, string_view_t frmt, const Args&... args)
+   {
+      logger_t& lg = logger_t::instance();
+      if (lg.enabled(lvl))
+         lg.write(lvl, frmt, args...);
+   }
+
+   template <class ...Args>
+   inline void debug(string_view_t frmt, const Args&... args) { log(level_t::debug, frmt, args...); }
+
+   template <class ...Args>
+   inline void info(string_view_t frmt, const Args&... args)  { log(level_t::info, frmt, args...); }
+
+   template <class ...Args>
+   inline void warn(string_view_t frmt, const Args&... args)  { log(level_t::warn, frmt, args...); }
+
+   template <class ...Args>
+   inline void error(string_view_t frmt, const Args&... args) { log(level_t::error, frmt, args...); }
+}
+
+#endif//logger_h
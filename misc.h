@@ -19,8 +19,9 @@ char fmt_req_cont[]  = R"({{ "sid": "0x{:08x}", "rid": "0x{:08x}", "service_code
 char fmt_resp_ok[]   = R"({{ "status": {}, "sid": "0x{:08x}", "rid": "0x{:08x}", "service_code": "{}", "operation": "{}", "msisdn": "{}", "content": "{}" }})""\n";
 
 char fmt_req_begin[]  = R"({{ "sid": "0x{:08x}", "rid": "0x{:08x}", "service_code": "{}", "operation": "{}", "msisdn": "{}" }})""\n";
-char fmt_req_error[]  = R"({}. [ gateway::{} error ]: request to {} failed: {{ "sid": "0x{:08x}", "message": "{}" }})""\n";
-char fmt_data_error[] = R"({}. [ gateway::{} error ]: {{ "sid": "0x{:08x}", "message": "{}" }})""\n";
+char fmt_log_request[] = R"([ gateway::{} info ]: request: {{ "sid": "0x{:08x}", "rid": "0x{:08x}", "service_code": "{}", "operation": "{}", "msisdn": "{}" }})""\n";
+char fmt_req_error[]  = R"([ gateway::{} error ]: request to {} failed: {{ "sid": "0x{:08x}", "message": "{}" }})""\n";
+char fmt_data_error[] = R"([ gateway::{} error ]: {{ "sid": "0x{:08x}", "message": "{}" }})""\n";
 
 namespace format
 {
@@ -112,70 +113,7 @@ namespace misc
       else if constexpr (is_same_v<T, CommandIDs> or is_same_v<T, uint32_t> or is_integral_v<T>)
          cmd_id = val;
 
-      switch (cmd_id)
-      {
-         case CommandIDs::Bind:
-            return "Bind";
-            break;
-
-         case CommandIDs::BindResp:
-            return "BindResp";
-            break;
-
-         case CommandIDs::UnBind:
-            return "UnBind";
-            break;
-
-         case CommandIDs::UnBindResp:
-            return "UnBindResp";
-            break;
-
-         case CommandIDs::Shake:
-            return "Shake";
-            break;
-
-         case CommandIDs::ShakeResp:
-            return "ShakeResp";
-            break;
-
-         case CommandIDs::Abort:
-            return "Abort";
-            break;
-
-         case CommandIDs::Begin:
-            return "Begin";
-            break;
-
-         case CommandIDs::End:
-            return "End";
-            break;
-
-         case CommandIDs::Continue:
-            return "Continue";
-            break;
-
-         case CommandIDs::Switch:
-            return "Switch";
-            break;
-
-         case CommandIDs::SwitchBegin:
-            return "SwitchBegin";
-            break;
-
-         case CommandIDs::ChargeInd:
-            return "ChargeInd";
-            break;
-
-         case CommandIDs::ChargeIndResp:
-            return "ChargeIndResp";
-            break;
-
-         default:
-            //
-            break;
-      }
-
-      return "Unknown Command";
+      return pdu::command_name(cmd_id);
    }
 
    cchar* op_name(pdu::USSDOperationTypes val)
@@ -268,10 +206,11 @@ namespace misc
       return false;
    }
 
+   /// Bounded by @text's size, it needn't be null terminated
    auto parse_json(Json::Value& json, string_view_t text)
    {
-      Json::Reader reader;
-      return reader.parse(text.data(), json);
+      static thread_local Json::Reader reader;
+      return reader.parse(text.data(), text.data() + text.size(), json);
    }
 
    bool setup_cli(ap::argmap& args, int argc, char* argv[])
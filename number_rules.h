@@ -0,0 +1,239 @@
+#ifndef number_rules_h
+#define number_rules_h
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "pdu/msisdn.h"
+
+//! @brief Number rules: allow and deny MSISDNs by prefix, numeric range or exact number
+/** A rule file has one rule per line, '#' starts a comment:
+    @code
+       allow 23324                         # prefix, any length
+       deny  2332419                       # longer prefixes don't override, deny always wins
+       allow 233200000000-233200999999     # numeric range, both ends the same number of digits
+       deny  =233241234567                 # exact number
+    @endcode
+    Rules are compiled to closed intervals of packed MSISDN keys (pdu/msisdn.h): a prefix of m digits
+    covers one interval per number length m..15, a range one interval, a number a single key. The
+    intervals are sorted and merged, so a check is a binary search over a few cache lines however
+    many rules overlap. <br>
+    Exact deny numbers, the rule sets that get large, are kept apart in a sorted array fronted by a
+    blocked bloom filter: the usual miss costs one cache line and no search.
+*/
+
+namespace gateway
+{
+   /// Disjoint, sorted, closed intervals of keys
+   struct key_ranges_t
+   {
+      void add(uint64_t first, uint64_t last) { pending.push_back({ first, last }); }
+
+      /// Sorts and merges what add() collected
+      void build()
+      {
+         std::sort(pending.begin(), pending.end());
+         firsts.clear();
+         lasts.clear();
+         for (auto [f, l] : pending)
+         {
+            if (!lasts.empty() and f <= lasts.back() + 1)
+               lasts.back() = std::max(lasts.back(), l);
+            else
+            {
+               firsts.push_back(f);
+               lasts.push_back(l);
+            }
+         }
+         pending.clear();
+         pending.shrink_to_fit();
+      }
+
+      bool contains(uint64_t key) const
+      {
+         auto it = std::upper_bound(firsts.begin(), firsts.end(), key);   // first interval starting after @key
+         return it != firsts.begin() and key <= lasts[size_t(it - firsts.begin()) - 1];
+      }
+
+      bool   empty() const { return firsts.empty(); }
+      size_t size()  const { return firsts.size(); }
+
+   private:
+      std::vector<std::pair<uint64_t, uint64_t>> pending;
+      std::vector<uint64_t> firsts, lasts;   ///< apart, so the search only touches @firsts
+   };
+
+   /// @brief Split block bloom filter: a key sets and tests 8 bits, one per 32 bit word of a single 32 byte block.
+   /// ~16 bits per key keep false positives near 0.1%.
+   struct blocked_bloom_t
+   {
+      void reserve(size_t keys) { blocks.assign(std::max<size_t>((keys * 16 + 255) / 256, 1), block_t {}); }
+
+      void insert(uint64_t key)
+      {
+         block_t& b = block(key);
+         uint32_t h = uint32_t(mix(key));
+         for (int i = 0; i < 8; ++i)
+            b.w[i] |= 1u << ((h * salt[i]) >> 27);
+      }
+
+      bool may_contain(uint64_t key) const
+      {
+         const block_t& b = block(key);
+         uint32_t h = uint32_t(mix(key));
+         uint32_t hit = ~0u;
+         for (int i = 0; i < 8; ++i)   // unrolled, no early exit
+            hit &= b.w[i] >> ((h * salt[i]) >> 27);
+         return hit & 1;
+      }
+
+      bool empty() const { return blocks.empty(); }
+
+   private:
+      struct alignas(32) block_t { uint32_t w[8] {}; };
+
+      static constexpr uint32_t salt[8] = { 0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                            0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+
+      static uint64_t mix(uint64_t k)
+      {
+         k ^= k >> 33;  k *= 0xff51afd7ed558ccdULL;
+         k ^= k >> 33;  k *= 0xc4ceb9fe1a85ec53ULL;
+         return k ^ (k >> 33);
+      }
+
+      const block_t& block(uint64_t key) const { return blocks[((mix(key) >> 32) * blocks.size()) >> 32]; }
+      block_t&       block(uint64_t key)       { return blocks[((mix(key) >> 32) * blocks.size()) >> 32]; }
+
+      std::vector<block_t> blocks;
+   };
+
+   struct number_rules_t
+   {
+      enum class verdict_t { none, allow, deny };
+
+      /// Exact deny lists longer than this get a bloom filter in front
+      static constexpr size_t bloom_min_keys = 4096;
+
+      verdict_t check(cuap::pdu::msisdn_key_t key) const
+      {
+         if (denied(key.raw))
+            return verdict_t::deny;
+         return allow.contains(key.raw) ? verdict_t::allow : verdict_t::none;
+      }
+
+      bool has_allow() const { return !allow.empty(); }
+      bool empty() const     { return allow.empty() and deny.empty() and deny_exact.empty(); }
+
+      /// Reads @path, see the file format above. Lines that don't parse are counted in @rejected.
+      /// @return false when @path can't be read
+      bool load(const std::string& path)
+      {
+         std::ifstream in(path);
+         if (!in)
+            return false;
+
+         std::vector<uint64_t> exact;
+         std::string line;
+         while (std::getline(in, line))
+         {
+            string_view_t l(line);
+            l = l.substr(0, l.find('#'));
+            string_view_t verb = token(l), arg = token(l);
+            if (verb.empty())
+               continue;
+
+            bool is_deny = verb == "deny";
+            if ((!is_deny and verb != "allow") or arg.empty() or !token(l).empty() or !add_rule(is_deny, arg, exact))
+               ++rejected;
+         }
+
+         std::sort(exact.begin(), exact.end());
+         exact.erase(std::unique(exact.begin(), exact.end()), exact.end());
+         deny_exact = std::move(exact);
+         if (deny_exact.size() >= bloom_min_keys)
+         {
+            bloom.reserve(deny_exact.size());
+            for (uint64_t k : deny_exact)
+               bloom.insert(k);
+         }
+
+         allow.build();
+         deny.build();
+         return true;
+      }
+
+      size_t rejected = 0;   ///< lines that weren't rules
+
+   private:
+      bool denied(uint64_t key) const
+      {
+         if (!deny.empty() and deny.contains(key))
+            return true;
+         if (deny_exact.empty() or (!bloom.empty() and !bloom.may_contain(key)))
+            return false;
+         return std::binary_search(deny_exact.begin(), deny_exact.end(), key);
+      }
+
+      bool add_rule(bool is_deny, string_view_t arg, std::vector<uint64_t>& exact)
+      {
+         using cuap::pdu::msisdn_key_t;
+         key_ranges_t& ranges = is_deny ? deny : allow;
+
+         if (arg[0] == '=')   // exact number
+         {
+            msisdn_key_t k(arg.substr(1));
+            if (!k)
+               return false;
+            if (is_deny)
+               exact.push_back(k.raw);
+            else
+               ranges.add(k.raw, k.raw);
+            return true;
+         }
+
+         if (size_t dash = arg.find('-'); dash != string_view_t::npos)   // numeric range
+         {
+            msisdn_key_t lo(arg.substr(0, dash)), hi(arg.substr(dash + 1));
+            if (!lo or !hi or lo.length() != hi.length() or hi < lo)
+               return false;
+            ranges.add(lo.raw, hi.raw);
+            return true;
+         }
+
+         msisdn_key_t p(arg);   // prefix: every length it can start
+         if (!p)
+            return false;
+         uint64_t span = 1;
+         for (size_t len = p.length(); len <= msisdn_key_t::max_digits; ++len, span *= 10)
+         {
+            uint64_t first = p.value() * span;
+            ranges.add(msisdn_key_t::pack(first, len), msisdn_key_t::pack(first + span - 1, len));
+         }
+         return true;
+      }
+
+      /// Next whitespace separated word of @l
+      static string_view_t token(string_view_t& l)
+      {
+         size_t b = l.find_first_not_of(" \t\r");
+         if (b == string_view_t::npos)
+         {
+            l = {};
+            return {};
+         }
+         size_t e = l.find_first_of(" \t\r", b);
+         string_view_t t = l.substr(b, e == string_view_t::npos ? string_view_t::npos : e - b);
+         l.remove_prefix(e == string_view_t::npos ? l.size() : e);
+         return t;
+      }
+
+      key_ranges_t          allow, deny;
+      std::vector<uint64_t> deny_exact;
+      blocked_bloom_t       bloom;
+   };
+}
+
+#endif//number_rules_h
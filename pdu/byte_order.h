@@ -0,0 +1,98 @@
+#ifndef byte_order_h
+#define byte_order_h
+
+#include <bit>
+#include <cstdint>
+#include <string.h>
+#include <type_traits>
+
+#ifndef constexpr_t
+   #ifdef __clang__
+      #define constexpr_t
+   #else
+      #define constexpr_t constexpr
+   #endif // __clang__
+#endif
+
+//! @brief Byte order: CUAP is big endian on the wire
+/** The host's order is known at compile time through std::endian, so a conversion is either a
+    single bswap or nothing at all, and never a runtime check or a build flag.
+*/
+
+namespace cuap::pdu
+{
+   template <class T>
+   constexpr T byteswap(T v) noexcept
+   {
+      static_assert(std::is_unsigned_v<T>, "byteswap is for unsigned integers");
+
+      if constexpr (sizeof(T) == 1)
+         return v;
+      else if constexpr (sizeof(T) == 2)
+         return T(__builtin_bswap16(v));
+      else if constexpr (sizeof(T) == 4)
+         return T(__builtin_bswap32(v));
+      else
+         return T(__builtin_bswap64(v));
+   }
+
+   constexpr bool host_is_big_endian = std::endian::native == std::endian::big;
+
+   /// Host order to big endian, and back: the same operation
+   template <class T>
+   constexpr T to_big_endian(T v) noexcept
+   {
+      if constexpr (host_is_big_endian)
+         return v;
+      else
+         return byteswap(v);
+   }
+
+   template <class T>
+   constexpr T from_big_endian(T v) noexcept { return to_big_endian(v); }
+
+   /// @brief An unsigned integer held in big endian order.
+   /// Same size as the wire field and no alignment needs beyond T's, it reads as host order.
+   /// The only ways in are from host order (constructor) or from wire bytes (load, from_wire),
+   /// so a value can't be converted twice.
+   template <class T>
+   struct big_endian
+   {
+      static_assert(std::is_unsigned_v<T>, "big_endian is for unsigned integers");
+
+      constexpr big_endian() = default;
+      constexpr big_endian(T host) noexcept : raw(to_big_endian(host)) {}
+
+      constexpr operator T() const noexcept { return from_big_endian(raw); }
+      constexpr T value()    const noexcept { return from_big_endian(raw); }
+
+      /// Wraps a value that already is in wire order
+      static constexpr big_endian from_wire(T wire) noexcept
+      {
+         big_endian b;
+         b.raw = wire;
+         return b;
+      }
+
+      /// Reads sizeof(T) possibly unaligned wire bytes at @p
+      static constexpr_t big_endian load(const void* p) noexcept
+      {
+         big_endian b;
+         memcpy(&b.raw, p, sizeof(T));
+         return b;
+      }
+
+      constexpr_t void store(void* p) const noexcept { memcpy(p, &raw, sizeof(T)); }
+
+      T raw = 0;   ///< wire order
+   };
+
+   using be16_t = big_endian<uint16_t>;
+   using be32_t = big_endian<uint32_t>;
+
+   static_assert(sizeof(be32_t) == sizeof(uint32_t));
+   static_assert(be32_t(0x01020304).value() == 0x01020304);
+   static_assert(host_is_big_endian or be32_t(0x01020304).raw == 0x04030201);
+}
+
+#endif//byte_order_h
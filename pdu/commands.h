@@ -0,0 +1,117 @@
+#ifndef commands_h
+#define commands_h
+
+#include <array>
+#include <initializer_list>
+
+#include "types.h"
+
+//! @brief Command table: what each CUAP command is called, how long it may be, and who handles it
+/** Command ids all fit in their low byte, so the table is 256 entries indexed by it and built at
+    compile time. Validating, naming and routing an inbound PDU is one indexed load. <br>
+    Lengths come from the schema.h layouts; a new command is one line in make_command_infos(),
+    and is routed once a handler is registered for it in a dispatch_table.
+*/
+
+namespace cuap::pdu
+{
+   struct command_info
+   {
+      uint32_t id      = CommandIDs::Error;
+      cchar*   name    = "Unknown Command";
+      uint16_t min_len = 0;
+      uint16_t max_len = 0;
+      bool     known   = false;
+
+      /// @len is the frame's command_len
+      constexpr bool valid_len(size_t len) const { return len >= min_len and len <= max_len; }
+   };
+
+   constexpr size_t command_slot(uint32_t id) { return id & 0xFF; }
+
+   template <class LAYOUT>
+   constexpr command_info make_command_info(uint32_t id, cchar* name)
+   {
+      return { id, name, uint16_t(LAYOUT::min_len), uint16_t(LAYOUT::max_len), true };
+   }
+
+   using command_infos_t = std::array<command_info, 256>;
+
+   constexpr command_infos_t make_command_infos()
+   {
+      command_infos_t t {};
+      for (command_info c : {
+         make_command_info<schema::bind>           (CommandIDs::Bind,          "Bind"),
+         make_command_info<schema::bind_resp>      (CommandIDs::BindResp,      "BindResp"),
+         make_command_info<schema::unbind>         (CommandIDs::UnBind,        "UnBind"),
+         make_command_info<schema::unbind_resp>    (CommandIDs::UnBindResp,    "UnBindResp"),
+         make_command_info<schema::begin>          (CommandIDs::Begin,         "Begin"),
+         make_command_info<schema::continue_>      (CommandIDs::Continue,      "Continue"),
+         make_command_info<schema::end>            (CommandIDs::End,           "End"),
+         make_command_info<schema::abort>          (CommandIDs::Abort,         "Abort"),
+         make_command_info<schema::switch_>        (CommandIDs::Switch,        "Switch"),
+         make_command_info<schema::switch_begin>   (CommandIDs::SwitchBegin,   "SwitchBegin"),
+         make_command_info<schema::charge_ind>     (CommandIDs::ChargeInd,     "ChargeInd"),
+         make_command_info<schema::charge_ind_resp>(CommandIDs::ChargeIndResp, "ChargeIndResp"),
+         make_command_info<schema::shake>          (CommandIDs::Shake,         "Shake"),
+         make_command_info<schema::shake_resp>     (CommandIDs::ShakeResp,     "ShakeResp") })
+      {
+         t[command_slot(c.id)] = c;
+      }
+      return t;
+   }
+
+   inline constexpr command_infos_t command_infos = make_command_infos();
+
+   /// Entry of @id, or the unknown entry when @id isn't a CUAP command
+   constexpr const command_info& command(uint32_t id)
+   {
+      const command_info& c = command_infos[command_slot(id)];
+      return c.id == id ? c : command_infos[CommandIDs::Error];
+   }
+
+   constexpr cchar* command_name(uint32_t id) { return command(id).name; }
+   constexpr bool   is_command(uint32_t id)   { return command(id).known; }
+
+   /// @brief command_infos plus a handler per command, e.g. a member function pointer.
+   /// Commands without a registered handler keep a null one: known, but nothing to do.
+   template <class Handler>
+   struct dispatch_table
+   {
+      struct entry
+      {
+         const command_info* info    = &command_infos[CommandIDs::Error];
+         Handler             handler = nullptr;
+      };
+
+      struct registration
+      {
+         uint32_t id;
+         Handler  handler;
+      };
+
+      constexpr dispatch_table(std::initializer_list<registration> handlers)
+      {
+         for (size_t i = 0; i < entries.size(); ++i)
+            entries[i].info = &command_infos[i];
+
+         for (const registration& r : handlers)
+            entries[command_slot(r.id)].handler = r.handler;
+      }
+
+      /// One indexed load, unknown ids land on the unknown entry
+      constexpr const entry& operator[](uint32_t id) const
+      {
+         const entry& e = entries[command_slot(id)];
+         return e.info->id == id ? e : entries[CommandIDs::Error];
+      }
+
+      std::array<entry, 256> entries {};
+   };
+
+   static_assert(command(CommandIDs::Begin).max_len == schema::begin::max_len);
+   static_assert(command(CommandIDs::Shake).min_len == HEADER_LEN);
+   static_assert(not is_command(0x0165) and not is_command(CommandIDs::Error));
+}
+
+#endif//commands_h
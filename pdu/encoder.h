@@ -0,0 +1,81 @@
+#ifndef encoder_h
+#define encoder_h
+
+#include "types.h"
+
+//! @brief Exact-length PDU encoding
+/** Fields are written once at the offsets and widths of their schema.h layout, straight into the
+    output buffer. <br>
+    command_len is computed from the layout instead of scanning a zeroed 256 byte buffer,
+    and exactly command_len bytes go out on the wire.
+*/
+
+namespace cuap::pdu
+{
+   /// @brief Begin, Continue and End as the SA sends them, every value in host order.
+   /// @msisdn and @service_code are held inline, @content is kept so a pooled reply reuses its storage.
+   struct begin_fields
+   {
+      using layout = schema::begin;
+
+      uint32_t       command_id     = CommandIDs::End;
+      uint32_t       command_status = 0;
+      uint32_t       sender_id      = OxFFFFFFFF;
+      uint32_t       receiver_id    = OxFFFFFFFF;
+      uint8_t        ussd_ver       = UssdVersion::PHASEII;
+      uint8_t        op_type        = USSDOpTypes::USSN;
+      uint8_t        code_scheme    = CodeScheme::Ox0F;
+      msisdn_t       msisdn;
+      service_code_t service_code;
+      string         content;
+
+      /// Header and fixed body, then the content without padding
+      uint32_t command_len() const
+      {
+         return layout::ussd_content::offset + layout::ussd_content::length(content);
+      }
+
+      /// Writes exactly command_len() bytes at @out
+      void encode(char* out) const
+      {
+         layout::command_len::set(out, command_len());
+         layout::command_id::set(out, command_id);
+         layout::command_status::set(out, command_status);
+         layout::sender_id::set(out, sender_id);
+         layout::receiver_id::set(out, receiver_id);
+         layout::ussd_ver::set(out, ussd_ver);
+         layout::ussd_op_type::set(out, op_type);
+         layout::msisdn::set(out, msisdn);
+         layout::service_code::set(out, service_code);
+         layout::code_scheme::set(out, code_scheme);
+         layout::ussd_content::set(out, content);
+      }
+
+      /// Back to defaults, @content keeps its capacity
+      void reset()
+      {
+         string keep = std::move(content);
+         *this   = begin_fields {};
+         content = std::move(keep);
+         content.clear();
+      }
+   };
+
+   /// Appends @pdu to @out, e.g. a trantor::MsgBuffer, without an intermediate copy.
+   /// @return bytes written
+   template <class Buffer, class Fields>
+   inline size_t encode_to(Buffer& out, const Fields& pdu)
+   {
+      size_t len = pdu.command_len();
+      out.ensureWritableBytes(len);
+      pdu.encode(out.beginWrite());
+      out.hasWritten(len);
+      return len;
+   }
+
+   using begin_fields_t    = begin_fields;
+   using continue_fields_t = begin_fields;
+   using end_fields_t      = begin_fields;
+}
+
+#endif//encoder_h
@@ -0,0 +1,87 @@
+#ifndef fixed_string_h
+#define fixed_string_h
+
+#include <compare>
+#include <cstdint>
+#include <functional>
+#include <string.h>
+
+#ifdef USE_BPSTD_SV
+   #include "bpstd/string_view.h"
+   using string_view_t = bpstd::string_view;
+#else
+   #include <string_view>
+   using string_view_t = std::string_view;
+#endif
+
+//! @brief Inline strings for the fixed width CUAP octet fields
+/** MSISDN and service code are 21 bytes on the wire, system-id 11. A fixed_string<N> holds up to N
+    chars in place, so copying one is a few word moves and never allocates. <br>
+    The buffer is rounded up to whole words and zero padded, the length lives in its last byte:
+    equality is a memcmp of constant size and hashing folds the same words, with no loop over chars.
+*/
+
+namespace cuap::pdu
+{
+   template <size_t N>
+   struct fixed_string
+   {
+      static_assert(N > 0 and N < 255, "length is kept in one byte");
+
+      /// Room for N chars, a '\0' after them and the length byte, in whole words
+      static constexpr size_t capacity = N;
+      static constexpr size_t storage  = (N + 2 + 7) & ~size_t(7);
+
+      constexpr fixed_string() = default;
+
+      /// Longer strings are truncated to N chars
+      fixed_string(string_view_t s) { assign(s); }
+      fixed_string(const char* s)   { assign(s); }
+
+      void assign(string_view_t s)
+      {
+         size_t n = s.size() < N ? s.size() : N;
+         memset(buf, 0, storage);
+         memcpy(buf, s.data(), n);
+         buf[storage - 1] = char(n);
+      }
+
+      void clear() { memset(buf, 0, storage); }
+
+      size_t      size()  const { return uint8_t(buf[storage - 1]); }
+      bool        empty() const { return size() == 0; }
+      const char* data()  const { return buf; }
+      const char* c_str() const { return buf; }
+
+      string_view_t view() const { return { buf, size() }; }
+      operator string_view_t() const { return view(); }
+
+      bool operator==(const fixed_string& o) const { return memcmp(buf, o.buf, storage) == 0; }
+      bool operator==(string_view_t s) const { return view() == s; }
+
+      auto operator<=>(const fixed_string& o) const { return view().compare(o.view()) <=> 0; }
+
+      size_t hash() const
+      {
+         uint64_t h = 0;
+         for (size_t i = 0; i < storage; i += 8)   // storage / 8 iterations, unrolled
+         {
+            uint64_t w;
+            memcpy(&w, buf + i, 8);
+            h = (h ^ w) * 0x9E3779B97F4A7C15ull;
+         }
+         return size_t(h ^ (h >> 32));
+      }
+
+   private:
+      char buf[storage] {};
+   };
+}
+
+template <size_t N>
+struct std::hash<cuap::pdu::fixed_string<N>>
+{
+   size_t operator()(const cuap::pdu::fixed_string<N>& s) const noexcept { return s.hash(); }
+};
+
+#endif//fixed_string_h
@@ -0,0 +1,45 @@
+#ifndef framing_h
+#define framing_h
+
+#include "types.h"
+
+//! Framing: splitting the USSDC byte stream into whole PDUs
+
+namespace cuap::pdu
+{
+   /// Largest PDU accepted from the USSDC, Switch/SwitchBegin are the biggest at 268 bytes
+   constexpr uint32_t MAX_PDU_LEN = 268;
+
+   enum class frame_status { ok, partial, corrupt };
+
+   /// Reads Header::CommandLength from the start of @data and converts it to host order
+   inline uint32_t frame_len(const char* data)
+   {
+      return be32_t::load(&data[Header::CommandLength]);
+   }
+
+   /// @brief Streaming decoder for length-prefixed CUAP PDUs.
+   /// Calls @fn with a view of every complete PDU in @buf, then retrieves it.
+   /// A trailing partial PDU is left in @buf until the rest of it arrives.
+   /// @param buf: anything exposing peek(), readableBytes() and retrieve(), i.e trantor::MsgBuffer
+   /// @return frame_status::corrupt when CommandLength is out of range, the stream can't be resynchronised then.
+   template <class Buffer, class Fn>
+   frame_status for_each_frame(Buffer* buf, Fn&& fn)
+   {
+      while (buf->readableBytes() >= HEADER_LEN)
+      {
+         uint32_t len = frame_len(buf->peek());
+         if (len < HEADER_LEN or len > MAX_PDU_LEN)
+            return frame_status::corrupt;
+
+         if (buf->readableBytes() < len)
+            return frame_status::partial;
+
+         fn(string_view_t { buf->peek(), len });
+         buf->retrieve(len);
+      }
+      return buf->readableBytes() ? frame_status::partial : frame_status::ok;
+   }
+}
+
+#endif//framing_h
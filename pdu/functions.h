@@ -12,6 +12,7 @@
 #endif
 
 #include "types.h"
+#include "commands.h"
 
 template <typename T>
 constexpr bool is_char_type()
@@ -128,19 +129,6 @@ namespace cuap
          return ret;
       }
 
-      template <typename T, class T2>
-      void get_body_str(T& hbuf, T* dest, T2 hfields, const size_t SZ)
-      {
-         memcpy(dest, &hbuf[hfields], SZ);
-      }
-
-      template <typename T, typename T2>
-      T get_from_body(T2& hbuf, BeginBody hfields)
-      {
-         T ret;
-         memcpy(&ret, &hbuf[hfields], sizeof(T));
-         return ret;
-      }
    }
 
 }
@@ -208,20 +196,22 @@ namespace cuap
       return ret;
    }
 
+   /// Header fields of raw wire bytes, read and written in host order
    namespace header
    {
       inline constexpr_t uint32_t header_field(Header hld, const char* buffer)
       {
-         uint32_t ret = 0;
-         memcpy(&ret, &buffer[hld], sizeof(uint32_t));
-         return ret;
+         return be32_t::load(&buffer[hld]);
       }
 
       inline constexpr_t uint32_t header_field(Header hld, const uchar_t buffer)
       {
-         uint32_t ret = 0;
-         memcpy(&ret, &buffer[hld], sizeof(uint32_t));
-         return ret;
+         return be32_t::load(&buffer[hld]);
+      }
+
+      inline constexpr_t void set_header_field(uchar_t buffer, Header hld, uint32_t val)
+      {
+         be32_t(val).store(&buffer[hld]);
       }
 
       inline constexpr_t uint32_t command_len(uchar_t buffer)
@@ -278,27 +268,27 @@ namespace cuap
 
       inline constexpr_t void set_command_len(uchar_t buffer, uint32_t val)
       {
-         set_field_u32(buffer, val, Header::CommandLength);
+         set_header_field(buffer, Header::CommandLength, val);
       }
 
       inline constexpr_t void set_command_id(uchar_t buffer, uint32_t val)
       {
-         set_field_u32(buffer, val, Header::CommandID);
+         set_header_field(buffer, Header::CommandID, val);
       }
 
       inline constexpr_t void set_command_status(uchar_t buffer, uint32_t val)
       {
-         set_field_u32(buffer, val, Header::CommandStatus);
+         set_header_field(buffer, Header::CommandStatus, val);
       }
 
       inline constexpr_t void set_sender_id(uchar_t buffer, uint32_t val)
       {
-         set_field_u32(buffer, val, Header::SenderID);
+         set_header_field(buffer, Header::SenderID, val);
       }
 
       inline constexpr_t void set_receiver_id(uchar_t buffer, uint32_t val)
       {
-         set_field_u32(buffer, val, Header::ReceiverID);
+         set_header_field(buffer, Header::ReceiverID, val);
       }
 
 		inline constexpr_t bool is_Bind(uchar_t buffer)       { return command_id(buffer) == 0x65; }
@@ -322,280 +312,12 @@ namespace cuap
       inline constexpr_t bool is_Shake(uchar_t buffer)      { return command_id(buffer) == 0x83; }
       inline constexpr_t bool is_ShakeResp(uchar_t buffer)  { return command_id(buffer) == 0x84; }
 
-      inline constexpr_t uint8_t cuap_pdu_arr[]
-              = {0x65, 0x66, 0x67, 0x68, 0x6f, 0x70, 0x71, 0x72, 0x74, 0x77, 0x75, 0x76, 0x83, 0x84};
-      inline constexpr_t bool is_cuap_msg(uchar_t buffer)
-		{
-			uint8_t cmd = command_id(buffer);
-			bool ret = false;
-			for (uint8_t i = 0; i < sizeof(cuap_pdu_arr); ++i)
-			{
-				if (cuap_pdu_arr[i] == cmd)
-				{
-					ret = true;
-					break;
-				}
-			}
-			return ret;
-		}
-   }
-
-   /// Body Fields
-   namespace body
-   {
-      /// Bind body of related fields operations
-      namespace bind_msg
-      {
-         template <class T2, uint N>
-         constexpr void system_id(uchar_t buffer, T2(&dest)[N])
-         {
-            get_field(buffer, dest, BindBody::System_ID, 11);
-         }
-
-         inline void set_system_id(uchar_t buffer, concepts::uchar_t val)
-         {
-            cuap::set_field(buffer, BindBody::System_ID, BindBody::Password, val, 11);
-         }
-
-         template <class T2, uint N>
-         constexpr void password(uchar_t buffer, T2(&dest)[N])
-         {
-            cuap::get_field(buffer, dest, BindBody::Password, 9);
-         }
-
-         template <class T>
-         void set_password(uchar_t buffer, T val)
-         {
-            cuap::set_field(buffer,
-                            BindBody::Password, BindBody::System_Type,
-                            val, 9);
-         }
-
-         template <class T2, uint N>
-         constexpr void system_type(uchar_t buffer, T2(&dest)[N])
-         {
-            cuap::get_field(buffer, dest, BindBody::System_Type, 13);
-         }
-
-         template <class T>
-         void set_system_type(uchar_t buffer, T val)
-         {
-            cuap::set_field(buffer,
-                            BindBody::System_Type, BindBody::Interface_Version,
-                            val, 13);
-         }
-
-         constexpr uint32_t interface_version(uchar_t buffer)
-         {
-            return cuap::get_field<uint32_t>(BindBody::Interface_Version, buffer);
-         }
-
-         inline constexpr_t void set_interface_version(uchar_t buffer, uint32_t val)
-         {
-            set_field_u32(buffer, val, BindBody::Interface_Version);
-         }
-      }
-
-      namespace bind_resp_msg = cuap::body::bind_msg;
-
-      /// Begin-family body (including Continue, End) fields operations
-      namespace begin_msg
-      {
-         constexpr uint8_t ussd_version (uchar_t buffer)
-         {
-            return buffer[BeginBody::Ussd_Version];
-         }
-
-         constexpr uint8_t ussd_op_type(char* buffer)
-         {
-            return buffer[BeginBody::Ussd_Op_Type];
-         }
-
-         constexpr uint8_t ussd_op_type(string_view_t buffer)
-         {
-            return buffer[BeginBody::Ussd_Op_Type];
-         }
-
-         constexpr uint8_t ussd_op_type(uchar_t buffer)
-         {
-            return buffer[BeginBody::Ussd_Op_Type];
-         }
-
-         constexpr uint8_t code_scheme(uchar_t buffer)
-         {
-            return buffer[BeginBody::Code_Scheme];
-         }
-
-         /// Get MSISDN from src and copy to dest
-         template <class T>
-         string msisdn(const T src)
-         {
-            string dest;
-            for (int i = BeginBody::MsIsdn; i < (BeginBody::MsIsdn + 21); ++i)
-            {
-               if (src[i] == '\0') { break; }
-               dest.append(1, src[i]);
-            }
-            return dest;
-         }
-
-         /// Get MSISDN from src and copy to dest
-         template <class T, class T2, uint N>
-         void msisdn(T* src, T2(&dest)[N])
-         {
-            get_field(src, dest, BeginBody::MsIsdn, 21);
-         }
-
-         template <class T>
-         void msisdn(T* src, std::string& dest)
-         {
-            get_field(src, dest, BeginBody::MsIsdn, 21);
-         }
-
-         /// Get Service Code from src and copy to dest
-         string service_code(string_view_t buffer)
-         {
-            string dest;
-            for (size_t i = BeginBody::Service_Code; i < (BeginBody::Service_Code + 21) && i < buffer.size(); ++i)
-            {
-               if (buffer[i] == '\0') { break; }
-               dest.append(1, buffer[i]);
-            }
-            return dest;
-         }
-
-         template <class T>
-         string service_code(T* buffer)
-         {
-            string dest;
-            for (int i = BeginBody::Service_Code; i < (BeginBody::Service_Code + 21); ++i)
-            {
-               if (buffer[i] == '\0') { break; }
-               dest.append(1, buffer[i]);
-            }
-            return dest;
-         }
-
-         /// Get Service Code from src and copy to dest
-         template <class T, class T2, uint N>
-         void service_code(T* buffer, T2(&dest)[N])
-         {
-            get_field(buffer, dest, BeginBody::Service_Code, 21);
-         }
-
-         template <class T, class T2, uint N>
-         void ussd_content(T* buffer, T2(&dest)[N])
-         {
-            get_field(buffer, dest,
-                      BeginBody::Ussd_Content,
-                      header::command_len(buffer) - BeginBody::Ussd_Content);
-         }
-
-         std::string ussd_content(string_view_t buffer)
-         {
-            string dest;
-            for (size_t i = BeginBody::Ussd_Content; i < buffer.size(); ++i)
-            {
-               if (buffer[i] == '\0') { break; }
-               dest.append(1, buffer[i]);
-            }
-            return dest;
-         }
-
-         template <class T>
-         std::string ussd_content(T* buffer, int size)
-         {
-            string dest;
-            for (int i = BeginBody::Ussd_Content; i < size; ++i)
-            {
-               if (buffer[i] == '\0') { break; }
-               dest.append(1, buffer[i]);
-            }
-            return dest;
-         }
-
-         template <class T, class T2>
-         T2* ussd_content(T* buffer)
-         {
-            return buffer + BeginBody::Ussd_Content;
-         }
-
-         constexpr void set_code_scheme(uchar_t buffer, uint8_t val)
-         {
-            buffer[BeginBody::Code_Scheme] = val;
-         }
-
-         template <class T>
-         void set_msisdn(uchar_t buffer, T val)
-         {
-            cuap::set_field(buffer, BeginBody::MsIsdn, BeginBody::Service_Code, val, 21);
-         }
-
-         template <class T>
-         void set_service_code(uchar_t buffer, T val)
-         {
-            cuap::set_field(buffer, BeginBody::Service_Code, BeginBody::Code_Scheme, val, 21);
-         }
-
-         template <class T>
-         void set_ussd_content(uchar_t buffer, T val)
-         {
-            cuap::set_field(buffer, BeginBody::Ussd_Content, BeginBody::Ussd_Content + 182,
-                  val, header::command_len(buffer) - BeginBody::Ussd_Content
-            );
-         }
-
-         constexpr void set_ussd_op_type(uchar_t buffer, uint8_t val)
-         {
-            buffer[BeginBody::Ussd_Op_Type] = val;
-         }
-
-         constexpr void set_ussd_version(uchar_t buffer, uint8_t val)
-         {
-            buffer[BeginBody::Ussd_Version] = val;
-         }
-
-      }
-
-      namespace continue_msg = body::begin_msg;
-      namespace end_msg      = body::begin_msg;
-
-      namespace switch_msg
-      {
-         constexpr uint8_t switchmode (uchar_t buffer)
-         {
-            return get_field<uint8_t>(static_cast<uint8_t>(Switch::SwitchMode), buffer);
-         }
-
-         template <class T, class T2, uint N>
-         void msisdn(T src, T2(&dest)[N])
-         {
-            get_field(src, dest, static_cast<uint8_t>(Switch::MsIsdn), 21);
-         }
-
-         template <class T, class T2, uint N>
-         void org_service_code (T src, T2(&dest)[N])
-         {
-            get_field(src, dest, static_cast<uint8_t>(Switch::Org_Service_Code ), 21);
-         }
-
-         template <class T, class T2, uint N>
-         void dest_service_code (T src, T2(&dest)[N])
-         {
-            get_field(src, dest, static_cast<uint8_t>(Switch::Dest_Service_Code), 21);
-         }
-
-         template <class T, class T2, uint N>
-         void ussd_content(T src, T2(&dest)[N])
-         {
-            get_field(src, dest, static_cast<uint8_t>(BeginBody::Ussd_Content),
-               header::command_len(src) - static_cast<uint8_t>(BeginBody::Ussd_Content)
-            );
-         }
-      }
-
+      /// One lookup in the command table, see commands.h
+      inline constexpr_t bool is_cuap_msg(uchar_t buffer) { return pdu::is_command(command_id(buffer)); }
    }
 
+   /// Body fields are read and written through the layouts in schema.h
+   namespace body = pdu::schema;
 }
 
 #endif//functions_h
@@ -12,11 +12,12 @@ namespace cuap::pdu
    struct basic_bind_resp : public basic_header<uint8_t, 64>
    {
       using basic_header<uint8_t, 64>::basic_header;
+      using layout = schema::bind_resp;
 
       template <class T, uint16_t N>
       void  set_system_id(T(&id)[N])
       {
-         assign_n(id, N, BindBody::System_ID, BindBody::Password);
+         set_system_id(string_view_t(reinterpret_cast<const char*>(id), N));
       }
 
       void  set_system_id(string_view_t id)
@@ -24,107 +25,54 @@ namespace cuap::pdu
       #if ENABLE_DEBUG
          fmt::print("System ID: {}\n", id);
       #endif // ENABLE_DEBUG
-         assign_n(id.data(), id.size(), BindBody::System_ID, BindBody::Password);
+         layout::system_id::set(buffer, id);
       }
 
       void  set_system_id(const uchar_t id, size_t sz)
       {
-         assign_n(id, sz, BindBody::System_ID, BindBody::Password);
+         set_system_id(string_view_t(reinterpret_cast<const char*>(id), sz));
       }
 
       /// @brief Gets System_ID from Message
       /// sets @id to null, then assign the target string to it.
       template <class T2, uint N>
-      void system_id(T2(&id)[N])
-      {
-         misc::set_null(id);
-         functions::get_body_str(*this, id, BindBody::System_ID, 11);
-      }
+      void system_id(T2(&id)[N]) { schema::copy_to<layout::system_id>(buffer, id); }
 
-      std::string system_id()
-      {
-         string ret;
-         for (int i = BindBody::System_ID; i < (BindBody::System_ID + 11) and i < capacity(); ++i)
-         {
-            if (buffer[i] == '\0') { break; }
-            ret += buffer[i];
-         }
-         return ret;
-      }
+      system_id_t system_id() const { return layout::system_id::get(buffer); }
    };
 
    struct basic_bind_msg : public basic_bind_resp
    {
       using basic_bind_resp::basic_bind_resp;
+      using layout = schema::bind;
 
-      std::string system_id()
-      {
-         string ret;
-         for (int i = BindBody::System_ID; i < BindBody::Password and i < capacity(); ++i)
-         {
-            if (buffer[i] == '\0') { break; }
-            ret += buffer[i];
-         }
-         return ret;
-      }
-
-      std::string password()
-      {
-         string ret;
-         for (int i = BindBody::Password; i < BindBody::System_Type and i < capacity(); ++i)
-         {
-            if (buffer[i] == '\0') { break; }
-            ret += buffer[i];
-         }
-         return ret;
-      }
-
-      void  set_system_id(string_view_t id)
-      {
-         assign_n(id.data(), id.size(), BindBody::System_ID, BindBody::Password);
-      }
+      password_t password() const { return layout::password::get(buffer); }
 
       /// @brief Gets Password from Message
       /// sets @pass to null, then assign the target string to it.
       template <typename T, size_t N>
-      void password(T(&pass)[N])
-      {
-         set_null(pass);
-         functions::get_body_str(*this, pass, BindBody::Password, 11);
-      }
+      void password(T(&pass)[N]) { schema::copy_to<layout::password>(buffer, pass); }
 
       void set_password(uchar_t pass, size_t sz)
       {
-         assign_n(pass, sz, BindBody::Password, BindBody::System_Type);
+         set_password(string_view_t(reinterpret_cast<const char*>(pass), sz));
       }
 
-      void set_password(string_view_t pass)
-      {
-         assign_n(pass.data(), pass.size(), BindBody::Password, BindBody::System_Type);
-      }
+      void set_password(string_view_t pass) { layout::password::set(buffer, pass); }
 
       template <typename T, size_t N>
-      void system_type(T(&sys_type)[N])
-      {
-         set_null(sys_type);
-         functions::get_body_str(*this, sys_type, BindBody::System_Type, 11);
-      }
+      void system_type(T(&sys_type)[N]) { schema::copy_to<layout::system_type>(buffer, sys_type); }
 
-      void set_system_type(string_view_t sys_type)
-      {
-         assign_n(sys_type.data(), sys_type.size(), BindBody::System_Type , BindBody::Interface_Version);
-      }
+      void set_system_type(string_view_t sys_type) { layout::system_type::set(buffer, sys_type); }
 
       void set_system_type(uchar_t tp, size_t sz)
       {
-         this->assign_n(tp, sz, BindBody::System_Type, BindBody::Interface_Version);
+         set_system_type(string_view_t(reinterpret_cast<const char*>(tp), sz));
       }
 
-      uint32_t interface_ver() { return get_u32(BindBody::Interface_Version); }
-      void set_interface_ver(uint32_t iv)
-      {
-         memcpy(&buffer[BindBody::Interface_Version], &iv, sizeof(uint32_t));
-      }
+      /// Host order, stored big endian
+      uint32_t interface_ver() const { return layout::interface_version::get(buffer); }
+      void set_interface_ver(uint32_t iv) { layout::interface_version::set(buffer, iv); }
 
    };
 
@@ -0,0 +1,127 @@
+#ifndef msisdn_h
+#define msisdn_h
+
+#if defined(__SSE2__)
+   #include <emmintrin.h>
+#endif
+
+#include "byte_order.h"
+#include "fixed_string.h"
+
+//! @brief MSISDNs packed into 64 bits, the key of everything looked up by number
+/** E.164 numbers are at most 15 digits, i.e. below 10^15 < 2^50. The value goes in the low 56
+    bits and the digit count in the top byte, so "0244..." and "244..." stay distinct and every
+    valid number has exactly one key. Comparing or hashing a key is one integer operation. <br>
+    parse() checks all 16 candidate bytes at once (SSE2) and converts eight digits per step (SWAR),
+    a leading '+' is accepted and dropped. Anything else that isn't 1..15 digits yields the invalid key 0.
+*/
+
+namespace cuap::pdu
+{
+   struct msisdn_key
+   {
+      static constexpr size_t max_digits = 15;
+
+      uint64_t raw = 0;
+
+      constexpr msisdn_key() = default;
+      constexpr explicit msisdn_key(uint64_t packed) : raw(packed) {}
+
+      /// 0 when @s isn't a MSISDN
+      explicit msisdn_key(string_view_t s) : raw(parse(s)) {}
+
+      constexpr bool     valid()  const { return raw != 0; }
+      constexpr size_t   length() const { return size_t(raw >> 56); }
+      constexpr uint64_t value()  const { return raw & ((uint64_t(1) << 56) - 1); }
+
+      constexpr explicit operator bool() const { return valid(); }
+      constexpr auto operator<=>(const msisdn_key&) const = default;
+
+      /// Back to digits, leading zeros included
+      fixed_string<max_digits> str() const
+      {
+         char     d[max_digits];
+         size_t   n = length();
+         uint64_t v = value();
+         for (size_t i = n; i-- > 0; v /= 10)
+            d[i] = char('0' + v % 10);
+         return string_view_t(d, n);
+      }
+
+      static constexpr uint64_t pack(uint64_t value, size_t digits) { return (uint64_t(digits) << 56) | value; }
+
+      static uint64_t parse(string_view_t s)
+      {
+         if (!s.empty() and s[0] == '+')
+            s.remove_prefix(1);
+
+         size_t n = s.size();
+         if (n == 0 or n > max_digits)
+            return 0;
+
+         // Right aligned behind '0's: leading zeros don't change the value, and both halves are
+         // whole eight digit groups
+         char d[16];
+         memset(d, '0', sizeof(d));
+         memcpy(d + sizeof(d) - n, s.data(), n);
+
+         if (!all_digits(d))
+            return 0;
+
+         return pack(eight_digits(d) * 100000000ull + eight_digits(d + 8), n);
+      }
+
+   private:
+      static bool all_digits(const char(&d)[16])
+      {
+      #if defined(__SSE2__)
+         __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+         __m128i lo = _mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1));
+         __m128i hi = _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1));
+         return _mm_movemask_epi8(_mm_and_si128(lo, hi)) == 0xFFFF;
+      #else
+         for (char c : d)
+            if (c < '0' or c > '9')
+               return false;
+         return true;
+      #endif
+      }
+
+      /// Eight ASCII digits, most significant first, to their value
+      static uint64_t eight_digits(const char* d)
+      {
+         if constexpr (host_is_big_endian)
+         {
+            uint64_t v = 0;
+            for (int i = 0; i < 8; ++i)
+               v = v * 10 + uint64_t(d[i] - '0');
+            return v;
+         }
+         else
+         {
+            uint64_t v;
+            memcpy(&v, d, sizeof(v));
+            v -= 0x3030303030303030ull;
+            v  = (v * 10) + (v >> 8);   // pairs of digits
+            v  = (((v & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+                  (((v >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+            return v;
+         }
+      }
+   };
+
+   using msisdn_key_t = msisdn_key;
+}
+
+/// Keys are already unique integers, mixed so unordered containers get well spread high bits too
+template <>
+struct std::hash<cuap::pdu::msisdn_key>
+{
+   size_t operator()(const cuap::pdu::msisdn_key& k) const noexcept
+   {
+      uint64_t h = k.raw * 0x9E3779B97F4A7C15ull;
+      return size_t(h ^ (h >> 32));
+   }
+};
+
+#endif//msisdn_h
@@ -2,4 +2,9 @@
 #include "session_phone.h"
 #include "service_forwading.h"
 #include "charging.h"
+#include "framing.h"
 
+#include "msisdn.h"
+#include "view.h"
+#include "encoder.h"
+#include "commands.h"
@@ -0,0 +1,220 @@
+#ifndef schema_h
+#define schema_h
+
+#include <algorithm>
+#include <cstdint>
+#include <string.h>
+
+#include "byte_order.h"
+#include "fixed_string.h"
+
+#ifdef USE_BPSTD_SV
+   #include "bpstd/string_view.h"
+   using string_view_t = bpstd::string_view;
+#else
+   #include <string_view>
+   using string_view_t = std::string_view;
+#endif
+
+//! @brief CUAP message layouts, the one place field offsets and widths are written down
+/** A field is a type carrying its offset, width, value type and byte order. Each field starts
+    where the previous one ends, and the static_asserts below pin the result to the CUAP spec. <br>
+    get()/set() only ever see compile-time offsets and widths, so they inline to a single load,
+    store or fixed size memcpy; no loops, no tables. Integers are big endian on the wire and
+    host order in and out of get()/set().
+*/
+
+namespace cuap::pdu::schema
+{
+   /// Unsigned integer
+   template <class T, size_t OFFSET>
+   struct uint_field
+   {
+      using value_type = T;
+      static constexpr size_t offset = OFFSET, width = sizeof(T), end = OFFSET + sizeof(T);
+
+      static T get(const void* buf)
+      {
+         return big_endian<T>::load(static_cast<const char*>(buf) + offset);
+      }
+
+      static void set(void* buf, T v)
+      {
+         big_endian<T>(v).store(static_cast<char*>(buf) + offset);
+      }
+
+      /// Bounds checked against a frame of @len bytes, 0 when the frame is too short
+      static T get(const void* buf, size_t len) { return len >= end ? get(buf) : T(0); }
+   };
+
+   /// Fixed width octet string, null padded
+   template <size_t OFFSET, size_t WIDTH>
+   struct octets_field
+   {
+      using value_type = string_view_t;
+      using fixed_type = fixed_string<WIDTH>;   ///< to keep a copy of the field
+      static constexpr size_t offset = OFFSET, width = WIDTH, end = OFFSET + WIDTH;
+
+      /// Bounded by the field width, the first '\0' and a frame of @len bytes
+      static string_view_t get(const void* buf, size_t len = end)
+      {
+         if (len <= offset)
+            return {};
+
+         const char* b = static_cast<const char*>(buf) + offset;
+         size_t      n = std::min(width, len - offset);
+         const void* z = memchr(b, '\0', n);
+         return { b, z ? size_t(static_cast<const char*>(z) - b) : n };
+      }
+
+      /// Truncates to the width, pads the rest with '\0'
+      static void set(void* buf, string_view_t v)
+      {
+         char*  b = static_cast<char*>(buf) + offset;
+         size_t n = std::min(v.size(), width);
+         memcpy(b, v.data(), n);
+         memset(b + n, 0, width - n);
+      }
+   };
+
+   /// Variable length octet string running to the end of the PDU, at most MAX bytes
+   template <size_t OFFSET, size_t MAX>
+   struct var_octets_field
+   {
+      using value_type = string_view_t;
+      static constexpr size_t offset = OFFSET, width = MAX, end = OFFSET + MAX;
+
+      static string_view_t get(const void* buf, size_t len = end)
+      {
+         return octets_field<OFFSET, MAX>::get(buf, len);
+      }
+
+      /// Writes no padding
+      /// @return bytes written, what the PDU's command_len grows by
+      static size_t set(void* buf, string_view_t v)
+      {
+         size_t n = std::min(v.size(), MAX);
+         memcpy(static_cast<char*>(buf) + offset, v.data(), n);
+         return n;
+      }
+
+      static constexpr size_t length(string_view_t v) { return std::min(v.size(), MAX); }
+   };
+
+   /// Copies a string field into a char array, for the fixed array accessors of the static_buffer PDUs
+   template <class F, class T, size_t N>
+   inline void copy_to(const void* buf, T(&dest)[N])
+   {
+      string_view_t v = F::get(buf);
+      size_t        n = std::min(v.size(), N);
+      memcpy(dest, v.data(), n);
+      memset(dest + n, 0, N - n);
+   }
+
+   struct header
+   {
+      using command_len    = uint_field<uint32_t, 0>;
+      using command_id     = uint_field<uint32_t, command_len::end>;
+      using command_status = uint_field<uint32_t, command_id::end>;
+      using sender_id      = uint_field<uint32_t, command_status::end>;
+      using receiver_id    = uint_field<uint32_t, sender_id::end>;
+
+      static constexpr size_t length = receiver_id::end;
+      static constexpr size_t min_len = length, max_len = length;
+   };
+
+   /// Begin, Continue, End
+   struct begin : header
+   {
+      using ussd_ver     = uint_field<uint8_t, header::length>;
+      using ussd_op_type = uint_field<uint8_t, ussd_ver::end>;
+      using msisdn       = octets_field<ussd_op_type::end, 21>;
+      using service_code = octets_field<msisdn::end, 21>;
+      using code_scheme  = uint_field<uint8_t, service_code::end>;
+      using ussd_content = var_octets_field<code_scheme::end, 182>;
+
+      static constexpr size_t min_len = ussd_content::offset, max_len = ussd_content::end;
+   };
+
+   struct bind : header
+   {
+      using system_id         = octets_field<header::length, 11>;
+      using password          = octets_field<system_id::end, 9>;
+      using system_type       = octets_field<password::end, 13>;
+      using interface_version = uint_field<uint32_t, system_type::end>;
+
+      static constexpr size_t min_len = interface_version::end, max_len = interface_version::end;
+   };
+
+   struct bind_resp : header
+   {
+      using system_id = octets_field<header::length, 11>;
+
+      static constexpr size_t min_len = system_id::end, max_len = system_id::end;
+   };
+
+   struct switch_ : header
+   {
+      using switch_mode       = uint_field<uint8_t, header::length>;
+      using msisdn            = octets_field<switch_mode::end, 21>;
+      using org_service_code  = octets_field<msisdn::end, 21>;
+      using dest_service_code = octets_field<org_service_code::end, 21>;
+      using ussd_content      = var_octets_field<dest_service_code::end, 182>;
+
+      static constexpr size_t min_len = ussd_content::offset, max_len = ussd_content::end;
+   };
+
+   struct switch_begin : header
+   {
+      using ussd_ver          = uint_field<uint8_t, header::length>;
+      using ussd_op_type      = uint_field<uint8_t, ussd_ver::end>;
+      using msisdn            = octets_field<ussd_op_type::end, 21>;
+      using org_service_code  = octets_field<msisdn::end, 21>;
+      using dest_service_code = octets_field<org_service_code::end, 21>;
+      using code_scheme       = uint_field<uint8_t, dest_service_code::end>;
+      using ussd_content      = var_octets_field<code_scheme::end, 182>;
+
+      static constexpr size_t min_len = ussd_content::offset, max_len = ussd_content::end;
+   };
+
+   struct charge_ind : header
+   {
+      using charge_ratio    = uint_field<uint32_t, header::length>;
+      using charge_type     = uint_field<uint32_t, charge_ratio::end>;
+      using charge_source   = octets_field<charge_type::end, 11>;
+      using charge_location = uint_field<uint8_t, charge_source::end>;
+
+      static constexpr size_t min_len = charge_location::end, max_len = charge_location::end;
+   };
+
+   using continue_   = begin;
+   using end         = begin;
+   using abort       = header;
+   using unbind      = header;
+   using unbind_resp = header;
+   using shake       = header;
+   using shake_resp  = header;
+   using charge_ind_resp = header;
+
+   // CUAP specification offsets
+   static_assert(header::length == 20);
+   static_assert(begin::msisdn::offset == 22 and begin::service_code::offset == 43 and begin::ussd_content::offset == 65);
+   static_assert(begin::max_len == 247);
+   static_assert(bind::password::offset == 31 and bind::system_type::offset == 40 and bind::interface_version::offset == 53);
+   static_assert(switch_::org_service_code::offset == 42 and switch_::ussd_content::offset == 84);
+   static_assert(switch_begin::dest_service_code::offset == 64 and switch_begin::ussd_content::offset == 86);
+   static_assert(switch_begin::max_len == 268);
+   static_assert(charge_ind::charge_source::offset == 28 and charge_ind::charge_location::offset == 39);
+}
+
+namespace cuap::pdu
+{
+   using msisdn_t       = schema::begin::msisdn::fixed_type;
+   using service_code_t = schema::begin::service_code::fixed_type;
+   using system_id_t    = schema::bind::system_id::fixed_type;
+   using password_t     = schema::bind::password::fixed_type;
+
+   static_assert(sizeof(msisdn_t) == 24 and sizeof(system_id_t) == 16);
+}
+
+#endif//schema_h
@@ -10,159 +10,71 @@
 
 namespace cuap::pdu
 {
-   struct basic_switch_msg : public basic_header<uint8_t, 268>
+   /// Switch and SwitchBegin share their string fields, only the offsets differ
+   template <class LAYOUT>
+   struct basic_switch_family : public basic_header<uint8_t, 268>
    {
          using basic_header<uint8_t, 268>::basic_header;
+         using layout = LAYOUT;
       public:
-         inline uint8_t switch_mode() { return buffer[static_cast<uint8_t>(Switch::SwitchMode)]; }
-         void   set_switch_mode(uint8_t swtch_mode)
-         {
-            buffer[static_cast<uint8_t>(Switch::SwitchMode)] = swtch_mode;
-         }
-
          template <uint32_t N>
-         void msisdn(uint8_t(&dest)[N])
-         {
-            misc::set_null(dest);
-            memcpy(dest, &buffer[static_cast<uint8_t>(Switch::MsIsdn)], 21); /** MSISDN is 21  byte octet string */
-         }
+         void msisdn(uint8_t(&dest)[N]) { schema::copy_to<typename layout::msisdn>(this->buffer, dest); }
 
          void set_msisdn(const uint8_t* _msisdn, size_t sz)
          {
-            assign_n(_msisdn, sz,
-                     static_cast<uint8_t>(Switch::MsIsdn),
-                     static_cast<uint8_t>(Switch::Org_Service_Code));
+            layout::msisdn::set(this->buffer, string_view_t(reinterpret_cast<const char*>(_msisdn), sz));
          }
 
          template <uint32_t N>
-         void originating_SC(uint8_t(&dest)[N])
-         {
-            misc::set_null(dest);
-            memcpy(dest, &buffer[static_cast<uint8_t>(Switch::Org_Service_Code)], 21);
-            /** Org_Service_Code is 21  byte octet string */
-         }
+         void originating_SC(uint8_t(&dest)[N]) { schema::copy_to<typename layout::org_service_code>(this->buffer, dest); }
 
          void set_originating_SC(const uint8_t* _orig_sc, size_t sz)
          {
-            assign_n(_orig_sc, sz,
-                     static_cast<uint8_t>(Switch::Org_Service_Code),
-                     static_cast<uint8_t>(Switch::Dest_Service_Code));
+            layout::org_service_code::set(this->buffer, string_view_t(reinterpret_cast<const char*>(_orig_sc), sz));
          }
 
          template <uint32_t N>
-         void destination_SC(uint8_t(&dest)[N])
-         {
-            misc::set_null(dest);
-            memcpy(dest, &buffer[static_cast<uint8_t>(Switch::Dest_Service_Code)], 21);
-            /** Org_Service_Code is 21  byte octet string */
-         }
+         void destination_SC(uint8_t(&dest)[N]) { schema::copy_to<typename layout::dest_service_code>(this->buffer, dest); }
 
          void set_destination_SC(const uint8_t* _dest_sc, size_t sz)
          {
-            assign_n(_dest_sc, sz,
-                     static_cast<uint8_t>(Switch::Dest_Service_Code),
-                     static_cast<uint8_t>(Switch::Ussd_Content));
+            layout::dest_service_code::set(this->buffer, string_view_t(reinterpret_cast<const char*>(_dest_sc), sz));
          }
 
          void ussd_content (uint8_t* dest, size_t sz)
          {
-            uint8_t content_offset = static_cast<uint8_t>(Switch::Ussd_Content);
+            string_view_t v = layout::ussd_content::get(this->buffer, this->capacity());
             misc::set_null(dest, sz);
-            memcpy(dest,
-                   &buffer[content_offset],
-                   command_len() - content_offset);
+            memcpy(dest, v.data(), std::min(v.size(), sz));
          }
 
          void set_ussd_content(const uint8_t* srv_code, size_t sz)
          {
-            uint8_t content_offset = static_cast<uint8_t>(Switch::Ussd_Content);
-            assign_n(srv_code, sz, content_offset, content_offset + 182);
+            this->erase(layout::ussd_content::offset, layout::ussd_content::end);
+            layout::ussd_content::set(this->buffer, string_view_t(reinterpret_cast<const char*>(srv_code), sz));
          }
-
    };
 
-   struct basic_switch_begin_msg : public pdu::basic_header<uint8_t, 268>
+   struct basic_switch_msg : public basic_switch_family<schema::switch_>
    {
-         using basic_header<uint8_t, 268>::basic_header;
-
+         using basic_switch_family<schema::switch_>::basic_switch_family;
       public:
+         inline uint8_t switch_mode() const { return layout::switch_mode::get(buffer); }
+         void   set_switch_mode(uint8_t swtch_mode) { layout::switch_mode::set(buffer, swtch_mode); }
+   };
 
-         inline uint8_t ussd_ver() { return buffer[static_cast<uint8_t>(SwitchBegin::Ussd_Version)]; }
-         void   set_ussd_ver(uint8_t ussd)
-         {
-            buffer[static_cast<uint8_t>(SwitchBegin::Ussd_Version)] = ussd;
-         }
-
-         inline uint8_t ussd_op_type() { return buffer[static_cast<uint8_t>(SwitchBegin::Ussd_Op_Type)]; }
-         void   set_ussd_op_type(uint8_t op_type)
-         {
-            buffer[static_cast<uint8_t>(SwitchBegin::Ussd_Op_Type)] = op_type;
-         }
-
-         inline uint8_t code_scheme() { return buffer[static_cast<uint8_t>(SwitchBegin::Code_Scheme)]; }
-         void   set_code_scheme(uint8_t csch)
-         {
-            buffer[static_cast<uint8_t>(SwitchBegin::Code_Scheme)] = csch;
-         }
-
-         template <uint32_t N>
-         void msisdn(uint8_t(&dest)[N])
-         {
-            misc::set_null(dest);
-            memcpy(dest, &buffer[static_cast<uint8_t>(SwitchBegin::MsIsdn)], 21); /** MSISDN is 21  byte octet string */
-         }
-
-         void set_msisdn(const uint8_t* _msisdn, size_t sz)
-         {
-            assign_n(_msisdn, sz,
-                     static_cast<uint8_t>(SwitchBegin::MsIsdn),
-                     static_cast<uint8_t>(SwitchBegin::Org_Service_Code));
-         }
-
-         template <uint32_t N>
-         void originating_SC(uint8_t(&dest)[N])
-         {
-            misc::set_null(dest);
-            memcpy(dest, &buffer[static_cast<uint8_t>(SwitchBegin::Org_Service_Code)], 21);
-            /** Org_Service_Code is 21  byte octet string */
-         }
-
-         void set_originating_SC(const uint8_t* _orig_sc, size_t sz)
-         {
-            assign_n(_orig_sc, sz,
-                     static_cast<uint8_t>(SwitchBegin::Org_Service_Code),
-                     static_cast<uint8_t>(SwitchBegin::Dest_Service_Code));
-         }
-
-         template <uint32_t N>
-         void destination_SC(uint8_t(&dest)[N])
-         {
-            misc::set_null(dest);
-            memcpy(dest, &buffer[static_cast<uint8_t>(SwitchBegin::Dest_Service_Code)], 21);
-            /** Org_Service_Code is 21  byte octet string */
-         }
-
-         void set_destination_SC(const uint8_t* _dest_sc, size_t sz)
-         {
-            assign_n(_dest_sc, sz,
-                     static_cast<uint8_t>(SwitchBegin::Dest_Service_Code),
-                     static_cast<uint8_t>(SwitchBegin::Ussd_Content));
-         }
+   struct basic_switch_begin_msg : public basic_switch_family<schema::switch_begin>
+   {
+         using basic_switch_family<schema::switch_begin>::basic_switch_family;
+      public:
+         inline uint8_t ussd_ver() const { return layout::ussd_ver::get(buffer); }
+         void   set_ussd_ver(uint8_t ussd) { layout::ussd_ver::set(buffer, ussd); }
 
-         void ussd_content (uint8_t* dest, size_t sz)
-         {
-            uint8_t content_offset = static_cast<uint8_t>(SwitchBegin::Ussd_Content);
-            misc::set_null(dest, sz);
-            memcpy(dest,
-                   &buffer[content_offset],
-                   command_len() - content_offset);
-         }
+         inline uint8_t ussd_op_type() const { return layout::ussd_op_type::get(buffer); }
+         void   set_ussd_op_type(uint8_t op_type) { layout::ussd_op_type::set(buffer, op_type); }
 
-         void set_ussd_content(const uint8_t* srv_code, size_t sz)
-         {
-            uint8_t content_offset = static_cast<uint8_t>(SwitchBegin::Ussd_Content);
-            assign_n(srv_code, sz, content_offset, content_offset + 182);
-         }
+         inline uint8_t code_scheme() const { return layout::code_scheme::get(buffer); }
+         void   set_code_scheme(uint8_t csch) { layout::code_scheme::set(buffer, csch); }
    };
 }
 
@@ -17,117 +17,66 @@ namespace cuap
       struct basic_begin : public basic_header<uint8_t, LENGTH_BEGIN>
       {
             using basic_header<uint8_t, LENGTH_BEGIN>::basic_header;
+            using layout = schema::begin;
          //enum Op_Type { USSR = 0x01, USSN = 0x02, USSDCResp = 0x03, ENDRelease = 0x04};
 
          public: /// Being, Continue, End Related methods
             template <uint32_t N>
-            void msisdn(uint8_t(&dest)[N])
-            {
-               misc::set_null(dest);
-               memcpy(dest, &buffer[BeginBody::MsIsdn], 21); /** MSISDN is 21  byte octet string */
-            }
+            void msisdn(uint8_t(&dest)[N]) { schema::copy_to<layout::msisdn>(buffer, dest); }
 
-            string msisdn()
-            {
-               string dest;
-               for (int i = BeginBody::MsIsdn; i < capacity() && i < (BeginBody::MsIsdn + 21); ++i)
-               {
-                  if (buffer[i] == '\0') { break; }
-                  dest.append(1, buffer[i]);
-               }
-               return dest;
-            }
+            msisdn_t msisdn() const { return layout::msisdn::get(buffer); }
 
-            void set_msisdn(string_view _msisdn)
-            {
-               assign_n(_msisdn.data(), _msisdn.size(), BeginBody::MsIsdn , BeginBody::Service_Code);
-            }
+            void set_msisdn(string_view _msisdn) { layout::msisdn::set(buffer, _msisdn); }
 
             void set_msisdn(const uint8_t* _msisdn, size_t sz)
             {
-               assign_n(_msisdn, sz, BeginBody::MsIsdn , BeginBody::Service_Code);
+               set_msisdn(string_view(reinterpret_cast<const char*>(_msisdn), sz));
             }
 
             template <uint32_t N>
-            void service_code(uint8_t(&dest)[N])
-            {
-               misc::set_null(dest);
-               memcpy(dest, &buffer[BeginBody::Service_Code], 21); /** Service_Code is 21 byte octet string */
-            }
+            void service_code(uint8_t(&dest)[N]) { schema::copy_to<layout::service_code>(buffer, dest); }
 
-            string service_code()
-            {
-               string dest;
-               short sz = BeginBody::Service_Code + 21;
-               for (int i = BeginBody::Service_Code; (i < sz) && (i < capacity()); ++i)
-               {
-                  if (buffer[i] == '\0') { break; }
-                  dest.append(1, buffer[i]);
-               }
-               return dest;
-            }
+            service_code_t service_code() const { return layout::service_code::get(buffer); }
 
-            void set_service_code(string_view svccode)
-            {
-               assign_n(svccode.data(), svccode.size(), BeginBody::Service_Code, BeginBody::Code_Scheme);
-            }
+            void set_service_code(string_view svccode) { layout::service_code::set(buffer, svccode); }
 
             void set_service_code(const uint8_t* srv_code, size_t sz)
             {
-               assign_n(srv_code, sz, BeginBody::Service_Code, BeginBody::Code_Scheme);
+               set_service_code(string_view(reinterpret_cast<const char*>(srv_code), sz));
             }
 
-            string ussd_content ()
-            {
-               string dest;
-               for (int i = BeginBody::Ussd_Content; i < capacity(); ++i)
-               {
-                  if (buffer[i] == '\0') { break; }
-                  dest.append(1, buffer[i]);
-               }
-               return dest;
-            }
+            string ussd_content () const { return string(layout::ussd_content::get(buffer, capacity())); }
 
             template <uint32_t N>
-            void ussd_content (uint8_t(&dest)[N])
-            {
-               misc::set_null(dest);
-               memcpy(dest, &buffer[BeginBody::Ussd_Content], command_len() - BeginBody::Ussd_Content);
-            }
+            void ussd_content (uint8_t(&dest)[N]) { schema::copy_to<layout::ussd_content>(buffer, dest); }
 
             void ussd_content (uint8_t* dest, size_t sz)
             {
+               string_view_t v = layout::ussd_content::get(buffer, capacity());
                misc::set_null(dest, sz);
-               memcpy(dest, &buffer[BeginBody::Ussd_Content], command_len() - BeginBody::Ussd_Content);
+               memcpy(dest, v.data(), std::min(v.size(), sz));
             }
 
+            /// Zero fills the whole field first, set_command_len() finds the end by scanning
             void set_ussd_content(string_view content)
             {
-               assign_n(content.data(), content.size(), BeginBody::Ussd_Content, BeginBody::Ussd_Content + 182);
+               erase(layout::ussd_content::offset, layout::ussd_content::end);
+               layout::ussd_content::set(buffer, content);
             }
 
             void set_ussd_content(const uint8_t* srv_code, size_t sz)
             {
-               assign_n(srv_code, sz, BeginBody::Ussd_Content, BeginBody::Ussd_Content + 182);
+               set_ussd_content(string_view(reinterpret_cast<const char*>(srv_code), sz));
             }
 
-            inline  uint8_t ussd_ver() { return buffer[BeginBody::Ussd_Version]; }
-            void    set_ussd_ver(uint8_t ussd)
-            {
-               buffer[BeginBody::Ussd_Version] = ussd;
-            }
+            inline  uint8_t ussd_ver() const { return layout::ussd_ver::get(buffer); }
+            void    set_ussd_ver(uint8_t ussd) { layout::ussd_ver::set(buffer, ussd); }
 
-            inline  uint8_t ussd_op_type() { return buffer[BeginBody::Ussd_Op_Type]; }
-            void    set_ussd_op_type(uint8_t op_type)
-            {
-               buffer[BeginBody::Ussd_Op_Type] = op_type;
-            }
+            inline  uint8_t ussd_op_type() const { return layout::ussd_op_type::get(buffer); }
+            void    set_ussd_op_type(uint8_t op_type) { layout::ussd_op_type::set(buffer, op_type); }
 
-            inline  uint8_t code_scheme() { return buffer[BeginBody::Code_Scheme]; }
-            void    set_code_scheme(uint8_t csch)
-            {
-               buffer[BeginBody::Code_Scheme] = csch;
-            }
+            inline  uint8_t code_scheme() const { return layout::code_scheme::get(buffer); }
+            void    set_code_scheme(uint8_t csch) { layout::code_scheme::set(buffer, csch); }
 
          public: /// Methods to test fot the operation type
             bool op_type_USSR() { return ussd_op_type() == 0x01; }
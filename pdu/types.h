@@ -7,14 +7,12 @@
    #define constexpr_t constexpr
 #endif // __clang__
 
-#if (CUAP_IS_BIG_ENDIAN == 1)
-   #define htobe16_mod htobe16
-   #define htobe32_mod htobe32
-#else
-   #define htobe16_mod
-   #define htobe32_mod
-#endif // USE_BIG_ENDIAN
+#if defined(__SSSE3__)
+   #include <tmmintrin.h>
+#endif
 
+#include "byte_order.h"
+#include "schema.h"
 #include "buffer.h"
 
 namespace cuap
@@ -36,24 +34,15 @@ namespace cuap
          Shake  = 0x00000083, ShakeResp = 0x00000084, Error = 0x00
       };
 
+      /// Header offsets, body layouts live in schema.h
       enum Header : uint8_t
-      { CommandLength = 0, CommandID = 4, CommandStatus = 8, SenderID = 12, ReceiverID = 16};
-
-      enum BindBody : uint8_t
-      { System_ID  = 20, Password = 31, System_Type = 40, Interface_Version = 53 };
-
-      enum BeginBody : uint8_t
-      { Ussd_Version = 20, Ussd_Op_Type = 21, MsIsdn = 22, Service_Code = 43, Code_Scheme = 64, Ussd_Content = 65 };
-
-      enum class Switch : uint8_t
-      { SwitchMode = 20, MsIsdn = 21, Org_Service_Code = 42, Dest_Service_Code = 63, Ussd_Content = 84 };
-
-      enum class SwitchBegin : uint8_t
-      { Ussd_Version = 20, Ussd_Op_Type = 21, MsIsdn = 22, Org_Service_Code = 43, Dest_Service_Code = 64,
-        Code_Scheme = 85, Ussd_Content = 86 };
-
-      enum class ChargeInd : uint8_t
-      { ChargeRatio = 20, ChargeType = 24, ChargeSource = 28, ChargeLocation = 39, };
+      {
+         CommandLength = schema::header::command_len::offset,
+         CommandID     = schema::header::command_id::offset,
+         CommandStatus = schema::header::command_status::offset,
+         SenderID      = schema::header::sender_id::offset,
+         ReceiverID    = schema::header::receiver_id::offset
+      };
 
       enum UssdVersion
       {
@@ -96,23 +85,104 @@ namespace cuap
 
       using CHARGEIND_RESP = Header;
 
+      enum class byte_order_t : uint8_t { host, wire };
+
+      /// @brief The 20 byte header, always in host order.
+      /// Bytes off the wire become a header_t through decode() and go back through encode(),
+      /// there's no way to convert one twice.
+      struct header_t
+      {
+         uint32_t command_len    = 0;
+         uint32_t command_id     = 0;
+         uint32_t command_status = 0;
+         uint32_t sender_id      = 0;
+         uint32_t receiver_id    = 0;
+
+         /// One pass over the 20 bytes: the first 16 with a single shuffle where SSSE3 is there
+         static header_t decode(const void* wire)
+         {
+            header_t h;
+            swap_copy(&h, wire);
+            return h;
+         }
+
+         void encode(void* wire) const { swap_copy(wire, this); }
+
+      private:
+         /// Copies 20 bytes, byte swapping each of the five 32 bit words
+         static void swap_copy(void* dest, const void* src)
+         {
+         #if defined(__SSSE3__)   // x86, always little endian
+            const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+            __m128i v = _mm_loadu_si128(static_cast<const __m128i*>(src));
+            _mm_storeu_si128(static_cast<__m128i*>(dest), _mm_shuffle_epi8(v, mask));
+
+            uint32_t last;
+            memcpy(&last, static_cast<const char*>(src) + 16, sizeof(last));
+            last = from_big_endian(last);
+            memcpy(static_cast<char*>(dest) + 16, &last, sizeof(last));
+         #else
+            uint32_t w[5];
+            memcpy(w, src, sizeof(w));
+            for (uint32_t& v : w)
+               v = from_big_endian(v);   // unrolled, and vectorised where the target allows
+            memcpy(dest, w, sizeof(w));
+         #endif
+         }
+      };
+
+      static_assert(sizeof(header_t) == HEADER_LEN, "header_t must map the wire header 1:1");
+
+      /// @brief Header of a PDU kept in a static_buffer.
+      /// The buffer knows whether its header currently holds host or wire order: getters always
+      /// return host order and setters take host order, whatever the state.
+      /// encode_header() and decode_header() only convert when the state is the other one,
+      /// calling either twice is harmless.
       template <class T = uint8_t, uint16_t SZ = 20>
       struct basic_header : public misc::static_buffer<T, SZ>
       {
          using misc::static_buffer<T, SZ>::static_buffer;
 
-         void set_command_len()                { this->assign((uint32_t)this->size(), Header::CommandLength); }
-         void set_command_len(uint32_t val)    { this->assign(val, Header::CommandLength); }
-         void set_command_id(uint32_t val)     { this->assign(val, Header::CommandID); }
-         void set_command_status(uint32_t val) { this->assign(val, Header::CommandStatus); }
-         void set_sender_id(uint32_t val)      { this->assign(val, Header::SenderID); }
-         void set_receiver_id(uint32_t val)    { this->assign(val, Header::ReceiverID); }
+         basic_header() = default;
+
+         /// Bytes as received, the header is in wire order
+         template <typename T2, typename L>
+         explicit constexpr_t basic_header(T2* buf, L len)
+            : misc::static_buffer<T, SZ>(buf, len), order(byte_order_t::wire) {}
+
+         void set_command_len()                { set_header_u32(this->size(), Header::CommandLength); }
+         void set_command_len(uint32_t val)    { set_header_u32(val, Header::CommandLength); }
+         void set_command_id(uint32_t val)     { set_header_u32(val, Header::CommandID); }
+         void set_command_status(uint32_t val) { set_header_u32(val, Header::CommandStatus); }
+         void set_sender_id(uint32_t val)      { set_header_u32(val, Header::SenderID); }
+         void set_receiver_id(uint32_t val)    { set_header_u32(val, Header::ReceiverID); }
+
+         const uint32_t command_len()  const  { return header_u32(Header::CommandLength); }
+         uint32_t command_id()  const   { return header_u32(Header::CommandID); }
+         uint32_t command_status() const { return header_u32(Header::CommandStatus); }
+         uint32_t sender_id()   const   { return header_u32(Header::SenderID); }
+         uint32_t receiver_id() const   { return header_u32(Header::ReceiverID); }
+
+         /// All five fields at once, in host order
+         header_t header() const
+         {
+            if (order == byte_order_t::wire)
+               return header_t::decode(this->buffer);
+
+            header_t h;
+            memcpy(&h, this->buffer, sizeof(h));
+            return h;
+         }
+
+         void set_header(const header_t& h)
+         {
+            if (order == byte_order_t::wire)
+               h.encode(this->buffer);
+            else
+               memcpy(this->buffer, &h, sizeof(h));
+         }
 
-         const uint32_t command_len()  const  { return this->get_u32(Header::CommandLength); }
-         uint32_t command_id()  const   { return this->get_u32(Header::CommandID); }
-         uint32_t command_status() const { return this->get_u32(Header::CommandStatus); }
-         uint32_t sender_id()   const   { return this->get_u32(Header::SenderID); }
-         uint32_t receiver_id() const   { return this->get_u32(Header::ReceiverID); }
+         byte_order_t byte_order() const { return order; }
 
          // Methods to test fot the command type/id
 
@@ -137,19 +207,40 @@ namespace cuap
          bool is_Shake()      { return command_id() == 0x83; }
          bool is_ShakeResp()  { return command_id() == 0x84; }
 
+         /// Header to wire order, a no-op when it already is
          void encode_header()
          {
-            set_command_len(htobe32(command_len()));
-            set_command_id(htobe32(command_id()));
-            set_command_status(htobe32(command_status()));
-            set_sender_id(htobe32(sender_id()));
-            set_receiver_id(htobe32(receiver_id()));
+            if (order == byte_order_t::wire)
+               return;
+            header_t h;
+            memcpy(&h, this->buffer, sizeof(h));
+            h.encode(this->buffer);
+            order = byte_order_t::wire;
          }
 
+         /// Header to host order, a no-op when it already is
          void decode_header()
          {
-            encode_header();
+            if (order == byte_order_t::host)
+               return;
+            header_t h = header_t::decode(this->buffer);
+            memcpy(this->buffer, &h, sizeof(h));
+            order = byte_order_t::host;
+         }
+
+      private:
+         uint32_t header_u32(Header field) const
+         {
+            uint32_t v = this->template get<uint32_t>(field);
+            return order == byte_order_t::wire ? from_big_endian(v) : v;
          }
+
+         void set_header_u32(uint32_t v, Header field)
+         {
+            this->assign(order == byte_order_t::wire ? to_big_endian(v) : v, field);
+         }
+
+         byte_order_t order = byte_order_t::host;
       };
 
       using header_msg_t = basic_header<uint8_t, 20>;
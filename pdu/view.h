@@ -0,0 +1,87 @@
+#ifndef view_h
+#define view_h
+
+#include "types.h"
+#include "msisdn.h"
+
+//! @brief Read-only views over a PDU in its receive buffer
+/** A view wraps the bytes of one frame as handed out by framing.h and copies nothing. <br>
+    Header fields come back in host order. Fixed width string fields come back as fixed_string
+    copies, the content as a string_view_t; both bounded by the field width, the null terminator
+    and the end of the frame. <br>
+    A view is only valid while the bytes it wraps are, i.e. within the message callback
+    unless the frame was copied somewhere that outlives it.
+*/
+
+namespace cuap::pdu
+{
+   /// Fields of @LAYOUT read in place
+   template <class LAYOUT>
+   struct basic_view
+   {
+      using layout = LAYOUT;
+
+      constexpr_t basic_view() = default;
+      constexpr_t basic_view(string_view_t frame) : frame(frame) {}
+
+      uint32_t command_len()    const { return get<schema::header::command_len>(); }
+      uint32_t command_id()     const { return get<schema::header::command_id>(); }
+      uint32_t command_status() const { return get<schema::header::command_status>(); }
+      uint32_t sender_id()      const { return get<schema::header::sender_id>(); }
+      uint32_t receiver_id()    const { return get<schema::header::receiver_id>(); }
+
+      /// All five header fields in one pass, frames shorter than a header read as zeros
+      header_t header() const
+      {
+         return frame.size() >= size_t(HEADER_LEN) ? header_t::decode(frame.data()) : header_t {};
+      }
+
+      const char* data() const { return frame.data(); }
+      size_t      size() const { return frame.size(); }
+      bool        valid() const { return frame.size() >= layout::min_len; }
+
+      /// Any field of the layout, bounded by the end of the frame
+      template <class FIELD>
+      typename FIELD::value_type get() const { return FIELD::get(frame.data(), frame.size()); }
+
+      /// Views of a derived layout may be read as their header
+      template <class L2>
+      operator basic_view<L2>() const { return basic_view<L2>(frame); }
+
+      string_view_t frame;
+   };
+
+   using header_view = basic_view<schema::header>;
+
+   /// Begin, Continue and End share the body layout
+   struct begin_view : public basic_view<schema::begin>
+   {
+      using basic_view::basic_view;
+
+      uint8_t ussd_ver()     const { return get<layout::ussd_ver>(); }
+      uint8_t ussd_op_type() const { return get<layout::ussd_op_type>(); }
+      uint8_t code_scheme()  const { return get<layout::code_scheme>(); }
+
+      msisdn_t       msisdn()       const { return get<layout::msisdn>(); }
+      service_code_t service_code() const { return get<layout::service_code>(); }
+
+      /// Packed MSISDN, invalid when the field isn't 1..15 digits
+      msisdn_key_t   msisdn_key()   const { return msisdn_key_t(get<layout::msisdn>()); }
+      string_view_t ussd_content() const { return get<layout::ussd_content>(); }
+   };
+
+   struct bind_resp_view : public basic_view<schema::bind_resp>
+   {
+      using basic_view::basic_view;
+
+      system_id_t system_id() const { return get<layout::system_id>(); }
+   };
+
+   using header_view_t    = header_view;
+   using begin_view_t     = begin_view;
+   using continue_view_t  = begin_view;
+   using abort_view_t     = header_view;
+   using bind_resp_view_t = bind_resp_view;
+}
+
+#endif//view_h
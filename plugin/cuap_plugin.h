@@ -0,0 +1,92 @@
+#ifndef cuap_plugin_h
+#define cuap_plugin_h
+
+/** @brief C ABI for in-process service plugins
+    A plugin is a shared object serving one or more service codes without the HTTP backend. It exports
+    one symbol, CUAP_PLUGIN_ENTRY, returning its cuap_plugin_t; the gateway loads it with dlopen for
+    every service code that names it under gateway.plugins in gateway.json.
+
+    Threads: handle() is called on the dialog's worker loop, the PDUs of one dialog always on the same
+    thread and in order, different dialogs on several threads at once. It must not block: anything slow
+    returns CUAP_PENDING and finishes through @complete, from any thread.
+
+    Memory: the strings of a cuap_request_t are views into the gateway's buffers, valid only during the
+    handle() call; copy what an async reply needs. A cuap_response_t's content is copied by the gateway
+    before handle() or @complete returns, the plugin keeps ownership.
+
+    Only plain C types cross the boundary and the struct layouts only ever grow at the end, guarded by
+    abi_version, so plugins built against an older header keep loading.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CUAP_PLUGIN_ABI_VERSION 1
+#define CUAP_PLUGIN_ENTRY       "cuap_plugin_entry"
+
+/* Commands, as on the wire */
+#define CUAP_BEGIN    0x0000006Fu
+#define CUAP_CONTINUE 0x00000070u
+#define CUAP_END      0x00000071u
+#define CUAP_ABORT    0x00000072u
+
+/* handle() results, and the status given to complete() */
+#define CUAP_DONE     0   /* @resp is filled in */
+#define CUAP_PENDING  1   /* @complete will be called, exactly once */
+#define CUAP_ERROR   -1   /* the subscriber gets the configured error */
+
+typedef struct cuap_str
+{
+   const char* data;
+   size_t      size;
+} cuap_str_t;
+
+typedef struct cuap_request
+{
+   uint32_t   command;        /* CUAP_BEGIN, CUAP_CONTINUE or CUAP_ABORT */
+   uint32_t   sid;            /* the USSDC's dialog id */
+   uint32_t   op_type;        /* USSD operation type of the PDU, 0 for an Abort */
+   cuap_str_t msisdn;
+   cuap_str_t service_code;   /* the code the plugin was registered for */
+   cuap_str_t content;        /* Begin: the string dialled, Continue: the subscriber's reply, Abort: empty */
+} cuap_request_t;
+
+typedef struct cuap_response
+{
+   uint32_t   command;        /* CUAP_CONTINUE to keep the dialog going, CUAP_END to close it */
+   uint32_t   op_type;        /* USSD operation type of the reply */
+   cuap_str_t content;
+} cuap_response_t;
+
+/** Finishes a request handle() returned CUAP_PENDING for. @status is CUAP_DONE with @resp, or
+    CUAP_ERROR with @resp NULL. For an Abort nothing is sent and @resp is ignored. */
+typedef void (*cuap_complete_fn)(void* token, int status, const cuap_response_t* resp);
+
+typedef struct cuap_plugin
+{
+   uint32_t    abi_version;   /* CUAP_PLUGIN_ABI_VERSION the plugin was built with */
+   const char* name;
+
+   /** Optional, once per service code the plugin is loaded for, before any handle(). @config is the
+       entry's "config" string. @return 0, or the plugin isn't used. */
+   int  (*init)(const char* config, void** instance);
+
+   /** Optional, at shutdown, once no request is in flight */
+   void (*destroy)(void* instance);
+
+   /** One Begin, Continue or Abort. @return CUAP_DONE, CUAP_PENDING or CUAP_ERROR */
+   int  (*handle)(void* instance, const cuap_request_t* req, cuap_response_t* resp,
+                  cuap_complete_fn complete, void* token);
+} cuap_plugin_t;
+
+typedef const cuap_plugin_t* (*cuap_plugin_entry_fn)(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif/*cuap_plugin_h*/
@@ -0,0 +1,118 @@
+#ifndef plugins_h
+#define plugins_h
+
+#include <string>
+#include <unordered_map>
+
+#include <dlfcn.h>
+
+#include "pdu/pdu.h"
+#include "plugin/cuap_plugin.h"
+#include "logger.h"
+
+//! @brief Service plugins: shared objects that answer dialogs in process, see plugin/cuap_plugin.h
+/** Each configured service code maps to a loaded plugin and the instance its init() made for that code.
+    A library named by several codes is opened once. The table is filled before the worker loops start
+    and only read after, so lookups from every worker need no locking.
+*/
+
+namespace gateway
+{
+   struct plugin_t
+   {
+      const cuap_plugin_t* api      = nullptr;
+      void*                instance = nullptr;
+      std::string          library;
+   };
+
+   struct plugins_t
+   {
+      plugins_t() = default;
+      plugins_t(const plugins_t&) = delete;
+      plugins_t& operator=(const plugins_t&) = delete;
+
+      ~plugins_t()
+      {
+         for (auto& [code, plugin] : by_code)
+         {
+            if (plugin.api->destroy)
+               plugin.api->destroy(plugin.instance);
+         }
+         for (auto& [path, handle] : libraries)
+            dlclose(handle);
+      }
+
+      /// Loads @library, if it isn't yet, and registers it for @service_code
+      /// @return false, logged, when it doesn't load or init() refuses
+      bool add(string_view_t service_code, const std::string& library, const std::string& config)
+      {
+         cuap::pdu::service_code_t code(service_code);
+         if (code.empty() or by_code.count(code))
+         {
+            logging::error("[ plugins_t::add error ]: service code '{}' is empty or has a plugin already\n", service_code);
+            return false;
+         }
+
+         const cuap_plugin_t* api = open(library);
+         if (!api)
+            return false;
+
+         plugin_t plugin { api, nullptr, library };
+         if (api->init and api->init(config.c_str(), &plugin.instance) != 0)
+         {
+            logging::error("[ plugins_t::add error ]: {} ('{}') refused service code '{}'\n", api->name, library, service_code);
+            return false;
+         }
+         by_code.emplace(code, std::move(plugin));
+         logging::info("[ plugins_t::add info ]: service code '{}' served by {} ('{}')\n", service_code, api->name, library);
+         return true;
+      }
+
+      /// Runs for every dialog PDU, so a gateway without plugins doesn't hash
+      const plugin_t* find(const cuap::pdu::service_code_t& code) const
+      {
+         if (by_code.empty())
+            return nullptr;
+         auto it = by_code.find(code);
+         return it == by_code.end() ? nullptr : &it->second;
+      }
+
+      bool   empty() const { return by_code.empty(); }
+      size_t size()  const { return by_code.size(); }
+
+   private:
+      const cuap_plugin_t* open(const std::string& library)
+      {
+         void*& handle = libraries[library];
+         if (!handle)
+            handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+         if (!handle)
+         {
+            libraries.erase(library);
+            logging::error("[ plugins_t::open error ]: {}\n", dlerror());
+            return nullptr;
+         }
+
+         auto entry = reinterpret_cast<cuap_plugin_entry_fn>(dlsym(handle, CUAP_PLUGIN_ENTRY));
+         const cuap_plugin_t* api = entry ? entry() : nullptr;
+         if (!api or !api->handle)
+         {
+            logging::error("[ plugins_t::open error ]: '{}' doesn't export a usable " CUAP_PLUGIN_ENTRY "()\n", library);
+            return nullptr;
+         }
+         if (api->abi_version == 0 or api->abi_version > CUAP_PLUGIN_ABI_VERSION)
+         {
+            logging::error("[ plugins_t::open error ]: '{}' needs plugin ABI {}, this gateway has {}\n",
+               library, api->abi_version, CUAP_PLUGIN_ABI_VERSION
+            );
+            return nullptr;
+         }
+         return api;
+      }
+
+      std::unordered_map<cuap::pdu::service_code_t, plugin_t> by_code;
+      std::unordered_map<std::string, void*>                  libraries;   ///< dlopen handles by path
+   };
+}
+
+#endif//plugins_h
@@ -0,0 +1,69 @@
+#ifndef reconnect_h
+#define reconnect_h
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+
+#include <trantor/net/EventLoop.h>
+
+//! Reconnect: link state and jittered exponential backoff to the USSDC
+
+namespace gateway
+{
+   enum class link_state_t { idle, connecting, binding, bound, backoff };
+
+   inline const char* link_state_name(link_state_t state)
+   {
+      switch (state)
+      {
+         case link_state_t::idle:       return "idle";
+         case link_state_t::connecting: return "connecting";
+         case link_state_t::binding:    return "binding";
+         case link_state_t::bound:      return "bound";
+         case link_state_t::backoff:    return "backoff";
+      }
+      return "";
+   }
+
+   /// @brief Schedules reconnect attempts on the link's loop.
+   /// Delay doubles per failed attempt from @min_delay up to @max_delay, with "equal jitter":
+   /// half the delay is fixed and half random, so links dropped together don't retry in lockstep.
+   /// Must be used from @loop's thread only.
+   struct reconnect_t
+   {
+      /// Runs @fn after the next backoff delay, a no-op when an attempt is already pending.
+      /// @return delay in seconds, 0 when nothing new was scheduled
+      double schedule(trantor::EventLoop* loop, std::function<void()> fn)
+      {
+         if (pending)
+            return 0;
+
+         double base  = std::min(max_delay, min_delay * std::pow(2.0, std::min(attempt, 30u)));
+         double delay = base / 2 + std::uniform_real_distribution<double>(0, base / 2)(rng);
+         ++attempt;
+
+         pending = true;
+         loop->runAfter(delay, [this, fn = std::move(fn)]
+         {
+            pending = false;
+            fn();
+         });
+         return delay;
+      }
+
+      /// Link is usable again, next failure starts from @min_delay
+      void reset() { attempt = 0; }
+
+      double   min_delay = 0.1;   ///< seconds
+      double   max_delay = 30.0;  ///< seconds
+      uint32_t attempt   = 0;
+
+   private:
+      bool         pending = false;
+      std::mt19937 rng { std::random_device{}() };
+   };
+}
+
+#endif//reconnect_h
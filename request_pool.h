@@ -0,0 +1,117 @@
+#ifndef request_pool_h
+#define request_pool_h
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <trantor/net/TcpConnection.h>
+#include <trantor/utils/MsgBuffer.h>
+
+#include "pdu/pdu.h"
+
+//! Pooled contexts for requests in flight to the HTTP backend
+
+namespace gateway
+{
+   struct worker_t;
+
+   /// @brief Free-list slab allocator.
+   /// Objects are carved out of CHUNK sized slabs that live as long as the pool, so once the pool
+   /// has grown to peak concurrency acquire()/release() never touch the heap.
+   /// T must have a `T* next_free` member.
+   /// acquire() runs on the TCP loop while release() runs on whichever loop completed the request,
+   /// hence the lock; it only guards a pointer swap.
+   template <class T, size_t CHUNK = 256>
+   struct slab_pool_t
+   {
+      slab_pool_t(size_t prealloc = CHUNK)
+      {
+         while (capacity < prealloc)
+            grow();
+      }
+
+      slab_pool_t(const slab_pool_t&) = delete;
+      slab_pool_t& operator=(const slab_pool_t&) = delete;
+
+      T* acquire()
+      {
+         std::lock_guard<std::mutex> lock(mtx);
+         if (!free_list)
+            grow();
+
+         T* obj    = free_list;
+         free_list = obj->next_free;
+         obj->next_free = nullptr;
+         return obj;
+      }
+
+      void release(T* obj)
+      {
+         obj->reset();
+
+         std::lock_guard<std::mutex> lock(mtx);
+         obj->next_free = free_list;
+         free_list = obj;
+      }
+
+   private:
+      void grow()
+      {
+         slabs.emplace_back(std::make_unique<T[]>(CHUNK));
+         T* slab = slabs.back().get();
+         for (size_t i = 0; i < CHUNK; ++i)
+         {
+            slab[i].next_free = free_list;
+            free_list = &slab[i];
+         }
+         capacity += CHUNK;
+      }
+
+      std::mutex  mtx;
+      T*          free_list = nullptr;
+      size_t      capacity = 0;
+      std::vector<std::unique_ptr<T[]>> slabs;
+   };
+
+   /// @brief Everything a Begin/Continue/Abort needs while its backend request is in flight.
+   /// Owns the inbound PDU, the reply being built and its encoded bytes, the connection the
+   /// reply goes out on and the worker owning the dialog.
+   struct request_ctx_t
+   {
+      cuap::pdu::continue_msg_t    pdu_req;
+      cuap::pdu::continue_fields_t pdu;
+      trantor::MsgBuffer           out {512};   ///< a Begin family PDU is at most 247 bytes
+      trantor::TcpConnectionPtr    conn;
+      worker_t*                    worker    = nullptr;
+      size_t                       req_len   = 0;
+      request_ctx_t*               next_free = nullptr;
+
+      /// Copies the inbound frame into pdu_req, the one copy it takes to hand it to another loop
+      void load(string_view_t frame)
+      {
+         req_len = std::min<size_t>(frame.size(), pdu_req.capacity());
+         memcpy(pdu_req.data(), frame.data(), req_len);
+      }
+
+      /// The inbound frame, read in place
+      cuap::pdu::begin_view_t request() const
+      {
+         return string_view_t(pdu_req.c_str(), req_len);
+      }
+
+      void reset()
+      {
+         conn.reset();
+         worker  = nullptr;
+         req_len = 0;
+         pdu.reset();   // pdu_req needs no clearing, request() never reads past req_len
+         out.retrieveAll();
+      }
+   };
+
+   using request_pool_t = slab_pool_t<request_ctx_t>;
+}
+
+#endif//request_pool_h
@@ -0,0 +1,182 @@
+#ifndef session_h
+#define session_h
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "pdu/types.h"
+#include "pdu/msisdn.h"
+
+//! Session table: maps USSDC dialogs to the IDs the gateway answers with
+
+namespace gateway
+{
+   using session_clock_t = std::chrono::steady_clock;
+
+   /// One USSD dialog, keyed by the sender_id the USSDC put in the Begin
+   struct session_t
+   {
+      uint32_t ussdc_id   = 0;  ///< USSDC's sender_id, our receiver_id
+      uint32_t gateway_id = 0;  ///< sender_id the gateway answers with
+
+      cuap::pdu::msisdn_key_t   msisdn;   ///< packed, str() gives the digits back
+      cuap::pdu::service_code_t service_code;
+
+      session_clock_t::time_point start, last_activity;
+
+      void touch() { last_activity = session_clock_t::now(); }
+   };
+
+   /// @brief Open-addressing (linear probing) hash table of live sessions.
+   /// Slots are allocated once by reserve(), so lookups and inserts never allocate.
+   /// Erase uses backward-shift deletion, hence no tombstones and probe lengths stay short.
+   /// Not thread-safe, only touch it from the loop that owns it.
+   struct session_table_t
+   {
+      struct slot_t
+      {
+         bool      used = false;
+         session_t session;
+      };
+
+      /// Sizes the table for @max_sessions concurrent dialogs, load factor stays <= 0.5
+      void reserve(size_t max_sessions)
+      {
+         size_t cap = 16;
+         for (shift = 28; cap < max_sessions * 2; --shift)
+            cap <<= 1;
+
+         slots.assign(cap, slot_t{});
+         mask  = cap - 1;
+         limit = max_sessions;
+         count = 0;
+      }
+
+      /// Tables sharing a link hand out disjoint gateway ids: @first, @first + @step, ...
+      void id_space(uint32_t first, uint32_t step)
+      {
+         id_first = first;
+         id_step  = step;
+         last_id  = first - step;   // wraps, next_id() then restarts at @first
+      }
+
+      /// Starts a new dialog for @ussdc_id and allocates its gateway ID.
+      /// An existing entry for @ussdc_id is restarted.
+      /// @return nullptr when the table is full
+      session_t* open(uint32_t ussdc_id, cuap::pdu::msisdn_key_t msisdn, const cuap::pdu::service_code_t& service_code)
+      {
+         size_t i = probe(ussdc_id);
+         if (!slots[i].used)
+         {
+            if (count >= limit)
+               return nullptr;
+            slots[i].used = true;
+            ++count;
+         }
+
+         session_t& s = slots[i].session;
+         s.ussdc_id   = ussdc_id;
+         s.gateway_id = next_id();
+         s.msisdn       = msisdn;
+         s.service_code = service_code;
+         s.start = s.last_activity = session_clock_t::now();
+         return &s;
+      }
+
+      session_t* find(uint32_t ussdc_id)
+      {
+         size_t i = probe(ussdc_id);
+         return slots[i].used ? &slots[i].session : nullptr;
+      }
+
+      bool erase(uint32_t ussdc_id)
+      {
+         size_t i = probe(ussdc_id);
+         if (!slots[i].used)
+            return false;
+
+         erase_slot(i);
+         return true;
+      }
+
+      /// Drops dialogs idle for longer than @idle, returns how many were dropped
+      size_t expire(session_clock_t::duration idle)
+      {
+         auto   deadline = session_clock_t::now() - idle;
+         size_t dropped  = 0;
+         for (size_t i = 0; i < slots.size();)
+         {
+            if (slots[i].used and slots[i].session.last_activity < deadline)
+            {
+               erase_slot(i);   // a later entry may shift into i, check it again
+               ++dropped;
+            }
+            else
+               ++i;
+         }
+         return dropped;
+      }
+
+      void clear()
+      {
+         for (slot_t& s : slots)
+            s.used = false;
+         count = 0;
+      }
+
+      size_t size() const     { return count; }
+      size_t capacity() const { return limit; }
+
+   private:
+      size_t home(uint32_t key) const
+      {
+         return uint32_t(key * 0x9E3779B1u) >> shift; // Fibonacci hashing, top bits are the well mixed ones
+      }
+
+      /// Index of @key's slot, or of the empty slot where it would go
+      size_t probe(uint32_t key) const
+      {
+         size_t i = home(key);
+         while (slots[i].used and slots[i].session.ussdc_id != key)
+            i = (i + 1) & mask;
+         return i;
+      }
+
+      void erase_slot(size_t i)
+      {
+         for (size_t j = i;;)
+         {
+            j = (j + 1) & mask;
+            if (!slots[j].used)
+               break;
+
+            size_t k = home(slots[j].session.ussdc_id);
+            bool stays = (i <= j) ? (i < k and k <= j) : (i < k or k <= j);
+            if (stays)
+               continue;
+
+            slots[i].session = slots[j].session;
+            i = j;
+         }
+         slots[i].used = false;
+         --count;
+      }
+
+      /// 0 and 0xFFFFFFFF are never handed out, USSDC treats 0xFFFFFFFF as "no ID"
+      uint32_t next_id()
+      {
+         uint32_t id = last_id + id_step;
+         if (id < last_id or id == cuap::pdu::OxFFFFFFFF)
+            id = id_first;
+         return last_id = id;
+      }
+
+      std::vector<slot_t> slots;
+      size_t   mask  = 0, limit = 0, count = 0;
+      uint32_t shift = 28;
+      uint32_t last_id = 0, id_first = 1, id_step = 1;
+   };
+}
+
+#endif//session_h
@@ -0,0 +1,291 @@
+#ifndef unix_pool_h
+#define unix_pool_h
+
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <drogon/HttpClient.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/net/Channel.h>
+#include <trantor/net/EventLoopThreadPool.h>
+#include <trantor/utils/MsgBuffer.h>
+
+#include "pdu/byte_order.h"
+#include "balanced_conns.h"
+#include "logger.h"
+
+//! @brief Backend over an AF_UNIX stream socket, for a backend on the same host
+/** Each request and response is one frame:
+    @code
+       +----------------+----------------+--------------------+
+       | length  (be32) | id      (be32) | payload (length)   |
+       +----------------+----------------+--------------------+
+    @endcode
+    The payload is the body the HTTP transport would send, as the data-transfer-mode encodes it. The
+    backend answers each frame with one frame of the same id, in any order; an answer to an id that
+    timed out is dropped. <br>
+    unix_pool_t takes the same requests and callbacks as http_pool_t, so the dialog code doesn't know
+    which one it talks to: the response handed back is a drogon::HttpResponse holding the payload.
+*/
+
+namespace gateway
+{
+   /// @brief N persistent connections to the backend's socket spread over several loops, balanced and
+   /// limited by balanced_conns_t. A connection is opened on first use, reopened on the next use after it
+   /// dropped or sat idle for @idle_timeout seconds; all of its I/O runs on its loop.
+   struct unix_pool_t
+   {
+      static constexpr uint32_t header_size   = 8;
+      static constexpr uint32_t max_frame_len = 16 << 20;   ///< a response longer than this is a broken stream
+
+      struct conn_t : conn_load_t
+      {
+         // Loop only
+         struct pending_t
+         {
+            drogon::HttpReqCallback cb;
+            trantor::TimerId        timer;
+         };
+
+         int                                     fd = -1;
+         std::unique_ptr<trantor::Channel>       channel;
+         trantor::MsgBuffer                      in, out;
+         uint32_t                                next_id = 0;
+         std::unordered_map<uint32_t, pending_t> pending;
+      };
+
+      void start(const string& socket_path, size_t nconns, size_t nloops)
+      {
+         path  = socket_path;
+         loops = std::make_unique<trantor::EventLoopThreadPool>(std::max<size_t>(nloops, 1), "eventloop.thread.unix");
+         loops->start();
+         conns.start(nconns, *loops, idle_timeout, [this](conn_t& c) { close_if_idle(c); });
+      }
+
+      /// Sends @req's body on the least loaded connection, @cb runs on that connection's loop.
+      /// When every connection is at @max_outstanding @cb runs at once with ReqResult::NetworkFailure.
+      void send(const drogon::HttpRequestPtr& req, drogon::HttpReqCallback cb)
+      {
+         conn_t* c = conns.acquire(max_outstanding);
+         if (!c)
+         {
+            logging::warn("[ unix_pool_t::send warn ]: All {} backend connection(s) at {} outstanding request(s)\n",
+               conns.size(), max_outstanding
+            );
+            cb(drogon::ReqResult::NetworkFailure, nullptr);
+            return;
+         }
+
+         // The frame is built here, the loop only assigns the id
+         auto   body  = req->body();
+         string frame(header_size + body.size(), '\0');
+         cuap::pdu::be32_t(uint32_t(body.size())).store(frame.data());
+         memcpy(frame.data() + header_size, body.data(), body.size());
+
+         c->loop->runInLoop([this, c, frame = std::move(frame), cb = std::move(cb)]() mutable
+         {
+            write(*c, std::move(frame), std::move(cb));
+         });
+      }
+
+      size_t outstanding() const { return conns.outstanding(); }
+      size_t size() const        { return conns.size(); }
+
+      uint32_t max_outstanding = 64;
+      double   idle_timeout    = 60;  ///< seconds
+      double   timeout         = 5;   ///< seconds per request
+
+   private:
+      /// Runs @cb once and gives its slot back; on @c's loop
+      static void finish(conn_t& c, drogon::HttpReqCallback& cb, drogon::ReqResult result, const drogon::HttpResponsePtr& response)
+      {
+         balanced_conns_t<conn_t>::release(c);
+         cb(result, response);
+      }
+
+      /// Runs on @c's loop
+      bool connect(conn_t& c)
+      {
+         sockaddr_un addr {};
+         addr.sun_family = AF_UNIX;
+         if (path.size() >= sizeof(addr.sun_path))
+         {
+            logging::error("[ unix_pool_t::connect error ]: socket path '{}' is longer than {} bytes\n", path, sizeof(addr.sun_path) - 1);
+            return false;
+         }
+         memcpy(addr.sun_path, path.data(), path.size());
+
+         int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+         if (fd < 0 or ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+         {
+            // a Unix socket connects at once or not at all: EAGAIN is a full backlog
+            logging::error("[ unix_pool_t::connect error ]: '{}': {}\n", path, strerror(errno));
+            if (fd >= 0)
+               ::close(fd);
+            return false;
+         }
+
+         c.fd = fd;
+         c.channel = std::make_unique<trantor::Channel>(c.loop, fd);
+         c.channel->setReadCallback([this, cp = &c]  { on_readable(*cp); });
+         c.channel->setWriteCallback([this, cp = &c] { on_writable(*cp); });
+         c.channel->setCloseCallback([this, cp = &c] { close(*cp, "closed by backend"); });
+         c.channel->setErrorCallback([this, cp = &c] { close(*cp, "socket error"); });
+         c.channel->enableReading();
+         return true;
+      }
+
+      /// Runs on @c's loop
+      void write(conn_t& c, string frame, drogon::HttpReqCallback cb)
+      {
+         if (c.fd < 0 and !connect(c))
+         {
+            finish(c, cb, drogon::ReqResult::NetworkFailure, nullptr);
+            return;
+         }
+
+         uint32_t id = c.next_id++;
+         cuap::pdu::be32_t(id).store(frame.data() + 4);
+         trantor::TimerId timer = c.loop->runAfter(timeout, [this, cp = &c, id] { expire(*cp, id); });
+         c.pending.emplace(id, conn_t::pending_t { std::move(cb), timer });
+
+         size_t sent = 0;
+         if (c.out.readableBytes() == 0)   // nothing queued: try the socket first, it usually takes it all
+         {
+            ssize_t n = ::send(c.fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+            if (n < 0 and errno != EAGAIN and errno != EWOULDBLOCK)
+            {
+               close(c, strerror(errno));
+               return;
+            }
+            sent = n > 0 ? size_t(n) : 0;
+         }
+         if (sent < frame.size())
+         {
+            c.out.append(frame.data() + sent, frame.size() - sent);
+            if (!c.channel->isWriting())
+               c.channel->enableWriting();
+         }
+      }
+
+      void on_writable(conn_t& c)
+      {
+         if (c.fd < 0)   // closed earlier in this poll round
+            return;
+         ssize_t n = ::send(c.fd, c.out.peek(), c.out.readableBytes(), MSG_NOSIGNAL);
+         if (n < 0)
+         {
+            if (errno != EAGAIN and errno != EWOULDBLOCK)
+               close(c, strerror(errno));
+            return;
+         }
+         c.out.retrieve(size_t(n));
+         if (c.out.readableBytes() == 0)
+            c.channel->disableWriting();
+      }
+
+      void on_readable(conn_t& c)
+      {
+         if (c.fd < 0)
+            return;
+         int     err = 0;
+         ssize_t n   = c.in.readFd(c.fd, &err);
+         if (n == 0)
+         {
+            close(c, "closed by backend");
+            return;
+         }
+         if (n < 0)
+         {
+            if (err != EAGAIN and err != EWOULDBLOCK)
+               close(c, strerror(err));
+            return;
+         }
+
+         while (c.in.readableBytes() >= header_size)
+         {
+            uint32_t len = cuap::pdu::be32_t::load(c.in.peek()).value();
+            uint32_t id  = cuap::pdu::be32_t::load(c.in.peek() + 4).value();
+            if (len > max_frame_len)
+            {
+               close(c, "oversized frame");
+               return;
+            }
+            if (c.in.readableBytes() < header_size + len)
+               break;
+
+            auto it = c.pending.find(id);
+            if (it != c.pending.end())
+            {
+               auto response = drogon::HttpResponse::newHttpResponse();
+               response->setBody(string(c.in.peek() + header_size, len));
+               drogon::HttpReqCallback cb = std::move(it->second.cb);
+               c.loop->invalidateTimer(it->second.timer);
+               c.pending.erase(it);
+               c.in.retrieve(header_size + len);
+               finish(c, cb, drogon::ReqResult::Ok, response);
+            }
+            else
+               c.in.retrieve(header_size + len);   // its request timed out
+         }
+      }
+
+      void expire(conn_t& c, uint32_t id)
+      {
+         auto it = c.pending.find(id);
+         if (it == c.pending.end())
+            return;
+         drogon::HttpReqCallback cb = std::move(it->second.cb);
+         c.pending.erase(it);
+         finish(c, cb, drogon::ReqResult::Timeout, nullptr);
+      }
+
+      /// Drops the connection and fails what was in flight on it, the next send() reconnects
+      void close(conn_t& c, const char* why)
+      {
+         if (c.fd < 0)
+            return;
+         if (!c.pending.empty())
+            logging::warn("[ unix_pool_t::close warn ]: '{}' {}, {} request(s) failed\n", path, why, c.pending.size());
+
+         // We may be inside one of the channel's callbacks, it's deleted once that returned
+         c.channel->disableAll();
+         c.channel->remove();
+         trantor::Channel* channel = c.channel.release();
+         c.loop->queueInLoop([channel] { delete channel; });
+         ::close(c.fd);
+         c.fd = -1;
+         c.in.retrieveAll();
+         c.out.retrieveAll();
+
+         auto pending = std::move(c.pending);
+         c.pending.clear();
+         for (auto& [id, p] : pending)
+         {
+            c.loop->invalidateTimer(p.timer);
+            finish(c, p.cb, drogon::ReqResult::NetworkFailure, nullptr);
+         }
+      }
+
+      /// Runs on @c's loop
+      void close_if_idle(conn_t& c)
+      {
+         // outstanding also counts a request queued to write() that isn't pending yet
+         if (c.fd < 0 or !c.idle_for(idle_timeout))
+            return;
+         close(c, "idle");
+      }
+
+      string path;
+      std::unique_ptr<trantor::EventLoopThreadPool> loops;
+      balanced_conns_t<conn_t> conns;
+   };
+}
+
+#endif//unix_pool_h
@@ -0,0 +1,434 @@
+#ifndef white_list_h
+#define white_list_h
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pdu/msisdn.h"
+#include "logger.h"
+
+//! @brief White-list: the MSISDNs the gateway serves
+/** Keys are packed MSISDNs (pdu/msisdn.h) kept sorted in Eytzinger order: the implicit binary
+    search tree laid out breadth first, so the first levels of every lookup share cache lines and
+    the next ones can be prefetched. A lookup is log2(n) branch free steps, ~24 for 10M numbers. <br>
+    The array is also the on-disk snapshot format: a 32 byte header then the keys, so loading a
+    snapshot is one mmap and no parsing. Text lists are parsed on all cores and saved as a
+    snapshot for the next start. <br>
+    A loaded list is never modified: on SIGHUP or when the file changes a new one is built, off
+    the loops, and swapped in as a shared_ptr; see white_list_watcher_t and worker_t::white_list.
+*/
+
+namespace gateway
+{
+   struct white_list_t
+   {
+      enum class source_t { none, snapshot, text };
+
+      /// Snapshot header, keys follow it. Host byte order, a snapshot is a per host cache of its text list
+      struct header_t
+      {
+         char     magic[8] = { 'C', 'U', 'A', 'P', 'W', 'L', 'S', '1' };
+         uint32_t order    = 0x01020304;   ///< read back differently on a host of the other byte order
+         uint32_t reserved = 0;
+         uint64_t count    = 0;            ///< keys, the array holds count + 1 slots, slot 0 is unused
+         uint64_t text_mtime = 0;          ///< ns, of the text list it was built from, 0 if none
+
+         bool valid() const { return header_t {}.order == order and memcmp(magic, header_t {}.magic, sizeof(magic)) == 0; }
+      };
+
+      white_list_t() = default;
+      white_list_t(const white_list_t&) = delete;
+      white_list_t& operator=(const white_list_t&) = delete;
+
+      white_list_t(white_list_t&& o) noexcept { *this = std::move(o); }
+      white_list_t& operator=(white_list_t&& o) noexcept
+      {
+         if (this != &o)
+         {
+            unmap();
+            owned = std::move(o.owned);
+            keys  = o.keys;   count = o.count;
+            map   = o.map;    map_len = o.map_len;
+            source = o.source; rejected = o.rejected;
+            o.keys = nullptr; o.count = 0; o.map = nullptr; o.map_len = 0;
+            if (!owned.empty())
+               keys = owned.data();
+         }
+         return *this;
+      }
+
+      ~white_list_t() { unmap(); }
+
+      bool   empty() const { return count == 0; }
+      size_t size()  const { return count; }
+
+      bool contains(cuap::pdu::msisdn_key_t key) const
+      {
+         if (!key)
+            return false;
+
+         uint64_t x = key.raw;
+         size_t   k = 1;
+         while (k <= count)
+         {
+            __builtin_prefetch(keys + 16 * k);   // the great-grandchildren share this line
+            k = 2 * k + (keys[k] < x);
+         }
+         k >>= __builtin_ffsll(~k);   // back up past the right turns taken after the match
+         return k != 0 and keys[k] == x;
+      }
+
+      /// @brief Loads @text, through @snapshot when it was built from @text as it is now.
+      /// A missing or stale snapshot is rebuilt from @text, failing to save it is not an error.
+      /// @snapshot may be empty to skip snapshots, @text may be a snapshot itself.
+      /// @return false when neither could be read
+      bool load(const std::string& text, const std::string& snapshot)
+      {
+         struct stat ts {};
+         bool     have_text = !text.empty() and ::stat(text.c_str(), &ts) == 0;
+         uint64_t mtime     = have_text ? uint64_t(ts.st_mtim.tv_sec) * 1000000000 + uint64_t(ts.st_mtim.tv_nsec) : 0;
+
+         if (have_text and map_file(text, 0))
+            return true;   // @text is a snapshot
+
+         if (!snapshot.empty() and map_file(snapshot, mtime))
+            return true;
+
+         if (!have_text or !parse_text(text))
+            return false;
+
+         if (!snapshot.empty())
+            save(snapshot, mtime);
+         return true;
+      }
+
+      /// Writes the keys as a snapshot, to a temporary renamed over @path so readers never see half a file
+      bool save(const std::string& path, uint64_t text_mtime = 0) const
+      {
+         header_t hdr;
+         hdr.count      = count;
+         hdr.text_mtime = text_mtime;
+
+         std::string tmp = path + ".tmp";
+         std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+         uint64_t slot0 = 0;
+         out.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+         out.write(reinterpret_cast<const char*>(count ? keys : &slot0), (count + 1) * sizeof(uint64_t));
+         out.close();
+         if (!out or ::rename(tmp.c_str(), path.c_str()) != 0)
+         {
+            ::unlink(tmp.c_str());
+            return false;
+         }
+         return true;
+      }
+
+      /// Builds from keys in any order, duplicates and invalid keys are dropped
+      void assign(std::vector<uint64_t> sorted)
+      {
+         std::sort(sorted.begin(), sorted.end());
+         sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+         if (!sorted.empty() and sorted.front() == 0)
+            sorted.erase(sorted.begin());
+
+         unmap();
+         owned.assign(sorted.size() + 1, 0);
+         size_t i = 0;
+         eytzinger(sorted, i, 1);
+         keys  = owned.data();
+         count = sorted.size();
+      }
+
+      source_t source   = source_t::none;
+      size_t   rejected = 0;   ///< text lines that weren't MSISDNs
+
+   private:
+      /// In-order walk of the implicit tree, filling it from the sorted keys
+      void eytzinger(const std::vector<uint64_t>& sorted, size_t& i, size_t k)
+      {
+         if (k >= owned.size())
+            return;
+         eytzinger(sorted, i, 2 * k);
+         owned[k] = sorted[i++];
+         eytzinger(sorted, i, 2 * k + 1);
+      }
+
+      /// Maps @path when it's a snapshot, built from a text list last modified at @mtime unless it's 0
+      bool map_file(const std::string& path, uint64_t mtime)
+      {
+         int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+         if (fd < 0)
+            return false;
+
+         struct stat st {};
+         header_t    hdr;
+         bool ok = ::fstat(fd, &st) == 0 and size_t(st.st_size) >= sizeof(hdr) and
+                   ::pread(fd, &hdr, sizeof(hdr), 0) == ssize_t(sizeof(hdr)) and hdr.valid() and
+                   (mtime == 0 or hdr.text_mtime == mtime) and
+                   size_t(st.st_size) == sizeof(hdr) + (hdr.count + 1) * sizeof(uint64_t);
+
+         void* m = ok ? ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0) : MAP_FAILED;
+         ::close(fd);
+         if (m == MAP_FAILED)
+            return false;
+
+         ::madvise(m, size_t(st.st_size), MADV_RANDOM);
+         unmap();
+         owned.clear();
+         map     = m;
+         map_len = size_t(st.st_size);
+         keys    = reinterpret_cast<const uint64_t*>(static_cast<const char*>(m) + sizeof(hdr));
+         count   = hdr.count;
+         source  = source_t::snapshot;
+         rejected = 0;
+         return true;
+      }
+
+      /// One MSISDN per line, parsed in chunks split at line ends, one per core
+      bool parse_text(const std::string& path)
+      {
+         std::ifstream in(path, std::ios::binary);
+         if (!in)
+            return false;
+         std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+         size_t nchunks = text.size() < (1 << 20) ? 1 : std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 16);
+         std::vector<size_t> cuts { 0 };
+         for (size_t c = 1; c < nchunks; ++c)
+         {
+            size_t at = text.find('\n', text.size() * c / nchunks);
+            cuts.push_back(at == std::string::npos ? text.size() : at + 1);
+         }
+         cuts.push_back(text.size());
+
+         std::vector<std::vector<uint64_t>> parts(nchunks);
+         std::vector<size_t> bad(nchunks, 0);
+         auto parse = [&](size_t c)
+         {
+            string_view_t rest(text.data() + cuts[c], std::max(cuts[c + 1], cuts[c]) - cuts[c]);
+            parts[c].reserve(rest.size() / 11);
+            while (!rest.empty())
+            {
+               size_t nl = rest.find('\n');
+               string_view_t line = rest.substr(0, nl);
+               rest.remove_prefix(nl == string_view_t::npos ? rest.size() : nl + 1);
+
+               while (!line.empty() and (line.back() == '\r' or line.back() == ' ' or line.back() == '\t'))
+                  line.remove_suffix(1);
+               if (line.empty())
+                  continue;
+
+               cuap::pdu::msisdn_key_t key(line);
+               if (key)
+                  parts[c].push_back(key.raw);
+               else
+                  ++bad[c];
+            }
+         };
+
+         std::vector<std::thread> threads;
+         for (size_t c = 1; c < nchunks; ++c)
+            threads.emplace_back(parse, c);
+         parse(0);
+         for (auto& t : threads)
+            t.join();
+
+         std::vector<uint64_t> all = std::move(parts[0]);
+         for (size_t c = 1; c < nchunks; ++c)
+            all.insert(all.end(), parts[c].begin(), parts[c].end());
+
+         assign(std::move(all));
+         source   = source_t::text;
+         rejected = 0;
+         for (size_t b : bad)
+            rejected += b;
+         return true;
+      }
+
+      void unmap()
+      {
+         if (map)
+            ::munmap(map, map_len);
+         map     = nullptr;
+         map_len = 0;
+         keys    = nullptr;
+         count   = 0;
+      }
+
+      std::vector<uint64_t> owned;   ///< built in memory, or empty when @map holds the keys
+      const uint64_t* keys  = nullptr;   ///< Eytzinger order, keys[1] is the root
+      size_t          count = 0;
+      void*           map   = nullptr;
+      size_t          map_len = 0;
+   };
+
+   /// @brief Tells when a white-list should be reloaded: on SIGHUP, or when one of its files is replaced or rewritten.
+   /// @on_reload runs on the watcher's own thread, so loading a big list never stalls a loop.
+   struct white_list_watcher_t
+   {
+      using on_reload_t = std::function<void()>;
+
+      ~white_list_watcher_t() { stop(); }
+
+      /// @watch_files: inotify on @files as well as SIGHUP
+      bool start(std::vector<std::string> files, bool watch_files, on_reload_t on_reload)
+      {
+         stop();
+         if (::pipe2(hup_pipe(), O_CLOEXEC | O_NONBLOCK) != 0 or ::pipe2(stop_pipe, O_CLOEXEC) != 0)
+         {
+            close_pipes();
+            return false;
+         }
+
+         struct sigaction sa {};
+         sa.sa_handler = [](int) { char c = 1; [[maybe_unused]] auto n = ::write(hup_pipe()[1], &c, 1); };
+         sa.sa_flags   = SA_RESTART;
+         sigemptyset(&sa.sa_mask);
+         if (::sigaction(SIGHUP, &sa, &old_hup) != 0)
+         {
+            close_pipes();
+            return false;
+         }
+
+         thread = std::thread([this, files = std::move(files), watch_files, on_reload = std::move(on_reload)]
+         {
+            run(files, watch_files, on_reload);
+         });
+         return true;
+      }
+
+      void stop()
+      {
+         if (!thread.joinable())
+            return;
+         char c = 1;
+         [[maybe_unused]] auto n = ::write(stop_pipe[1], &c, 1);
+         thread.join();
+         ::sigaction(SIGHUP, &old_hup, nullptr);   // before the pipe goes, the handler writes to it
+         close_pipes();
+      }
+
+      /// Waits this long after a file event, so a list written in several steps is read once, whole
+      int settle_ms = 500;
+
+   private:
+      /// Written from the signal handler, hence static
+      static int* hup_pipe()
+      {
+         static int fds[2] = { -1, -1 };
+         return fds;
+      }
+
+      void close_pipes()
+      {
+         for (int* fds : { hup_pipe(), stop_pipe })
+         {
+            for (int i = 0; i < 2; ++i)
+            {
+               if (fds[i] >= 0)
+                  ::close(fds[i]);
+               fds[i] = -1;
+            }
+         }
+      }
+
+      using watches_t = std::vector<std::pair<int, std::string>>;   ///< watch descriptor, file name in its directory
+
+      void run(const std::vector<std::string>& files, bool watch_files, const on_reload_t& on_reload)
+      {
+         int       ino = watch_files ? ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC) : -1;
+         if (watch_files and ino < 0)
+            logging::warn("[ white_list_watcher_t::run warn ]: inotify: {}, reloading on SIGHUP only\n", strerror(errno));
+         watches_t watches;
+         for (const std::string& file : files)
+         {
+            std::string dir = ".", name = file;
+            if (size_t slash = file.rfind('/'); slash != std::string::npos)
+            {
+               dir  = slash ? file.substr(0, slash) : "/";
+               name = file.substr(slash + 1);
+            }
+            if (ino >= 0)   // the directory, so a file replaced by rename is seen too
+               watches.emplace_back(::inotify_add_watch(ino, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE), name);
+         }
+
+         pollfd fds[3] = { { stop_pipe[0], POLLIN, 0 }, { hup_pipe()[0], POLLIN, 0 }, { ino, POLLIN, 0 } };
+         for (;;)
+         {
+            if (::poll(fds, ino >= 0 ? 3 : 2, -1) < 0)
+            {
+               if (errno == EINTR)
+                  continue;
+               logging::error("[ white_list_watcher_t::run error ]: poll: {}, no more reloads\n", strerror(errno));
+               break;
+            }
+            if (fds[0].revents)
+               break;
+
+            bool reload = false;
+            if (fds[1].revents)
+            {
+               char buf[64];
+               while (::read(hup_pipe()[0], buf, sizeof(buf)) > 0) {}
+               reload = true;
+            }
+            if (ino >= 0 and fds[2].revents)
+            {
+               reload |= file_changed(ino, watches);
+               if (reload)
+               {
+                  ::poll(fds, 1, settle_ms);    // or until stopped
+                  file_changed(ino, watches);   // drop what the settling produced
+               }
+            }
+            if (reload)
+               on_reload();
+         }
+
+         if (ino >= 0)
+            ::close(ino);
+      }
+
+      /// Drains @ino, true when one of the events is about a watched file
+      static bool file_changed(int ino, const watches_t& watches)
+      {
+         alignas(inotify_event) char buf[4096];
+         bool    hit = false;
+         ssize_t len;
+         while ((len = ::read(ino, buf, sizeof(buf))) > 0)
+         {
+            for (char* p = buf; p < buf + len;)
+            {
+               auto* ev = reinterpret_cast<inotify_event*>(p);
+               for (const auto& [wd, name] : watches)
+                  hit |= ev->len and ev->wd == wd and name == ev->name;
+               p += sizeof(inotify_event) + ev->len;
+            }
+         }
+         return hit;
+      }
+
+      std::thread      thread;
+      int              stop_pipe[2] = { -1, -1 };
+      struct sigaction old_hup {};   ///< SIGHUP's action before start(), put back by stop()
+   };
+}
+
+#endif//white_list_h
@@ -0,0 +1,80 @@
+#ifndef worker_h
+#define worker_h
+
+#include <memory>
+#include <vector>
+
+#include <trantor/net/EventLoopThreadPool.h>
+
+#include "session.h"
+#include "white_list.h"
+#include "number_rules.h"
+
+//! Workers: loops that own the dialogs
+
+namespace gateway
+{
+   /// @brief One loop and the share of the session table it owns.
+   /// @sessions is only ever touched on @loop, so it needs no lock.
+   /// @white_list and @number_rules are too: a reload swaps the pointers on @loop, between two PDUs,
+   /// so a lookup never sees them change and the old ones are freed once every worker let go of them.
+   struct worker_t
+   {
+      trantor::EventLoop* loop = nullptr;
+      session_table_t     sessions;
+      std::shared_ptr<const white_list_t> white_list;   ///< null or empty: everyone is served
+      std::shared_ptr<const number_rules_t> number_rules;
+      size_t              index = 0;
+   };
+
+   /// @brief Spreads dialogs over N loops by USSDC session id.
+   /// Every PDU of a dialog lands on the same worker and is queued there in arrival order,
+   /// so a Continue can never overtake its Begin, while separate dialogs run in parallel.
+   struct worker_pool_t
+   {
+      /// @max_sessions is split evenly across the workers
+      void start(size_t nworkers, size_t max_sessions)
+      {
+         size_t n = std::max<size_t>(nworkers, 1);
+         loops = std::make_unique<trantor::EventLoopThreadPool>(n, "eventloop.thread.worker");
+         loops->start();
+
+         workers.clear();
+         for (size_t i = 0; i < n; ++i)
+         {
+            auto w   = std::make_unique<worker_t>();
+            w->loop  = loops->getNextLoop();
+            w->index = i;
+            w->sessions.reserve((max_sessions + n - 1) / n);
+            w->sessions.id_space(uint32_t(i + 1), uint32_t(n));
+            workers.emplace_back(std::move(w));
+         }
+      }
+
+      /// Worker owning dialog @ussdc_id, ids from the USSDC are often sequential so they're mixed first
+      worker_t& for_session(uint32_t ussdc_id)
+      {
+         uint64_t h = uint32_t(ussdc_id * 0x9E3779B1u);
+         return *workers[(h * workers.size()) >> 32];
+      }
+
+      /// Runs @fn(worker_t&) on every worker's own loop
+      template <class Fn>
+      void each(Fn fn)
+      {
+         for (auto& w : workers)
+         {
+            worker_t* wp = w.get();
+            wp->loop->runInLoop([wp, fn] { fn(*wp); });
+         }
+      }
+
+      size_t size() const { return workers.size(); }
+
+   private:
+      std::unique_ptr<trantor::EventLoopThreadPool> loops;
+      std::vector<std::unique_ptr<worker_t>> workers;
+   };
+}
+
+#endif//worker_h
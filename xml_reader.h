@@ -0,0 +1,355 @@
+#ifndef xml_reader_h
+#define xml_reader_h
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "codec.h"
+
+//! @brief One pass reader for the XML backend's response
+/** The response is a root element with one child per member, the root's name doesn't matter:
+    @code
+       <?xml version="1.0" encoding="UTF-8"?>
+       <response>
+          <command>113</command>
+          <op_type>2</op_type>
+          <msisdn>233241234567</msisdn>
+          <content>Bye &amp; thanks</content>
+       </response>
+    @endcode
+    Children are picked out in one scan, their text as views into the body, or into a buffer the
+    reader keeps when it holds entities or CDATA. Attributes, comments and processing instructions
+    are skipped, as are unknown children with whatever they nest. This isn't a validating parser:
+    namespaces, DTDs and entities beyond the five predefined and character references aren't
+    supported, and a body using them doesn't decode.
+*/
+
+namespace gateway
+{
+   struct xml_reader_t
+   {
+      /// @out's views stay valid until the next read() or until @body goes
+      bool read(string_view_t body, backend_response_t& out)
+      {
+         out = {};
+         p   = body.data();
+         end = p + body.size();
+
+         if (!skip_misc())
+            return false;
+
+         string_view_t root;
+         bool          empty;
+         if (!start_tag(root, empty))
+            return false;
+         if (empty)
+            return skip_misc() and p == end;
+
+         for (;;)
+         {
+            if (!skip_misc())
+               return false;
+            if (starts_with("</"))
+               break;
+
+            string_view_t name;
+            if (!start_tag(name, empty))
+               return false;
+
+            bool ok = true;
+            if (name == "command")
+               ok = number(name, empty, out.command, out.has_command);
+            else if (name == "op_type")
+               ok = number(name, empty, out.op_type, out.has_op_type);
+            else if (name == "msisdn")
+               ok = text(name, empty, msisdn_buf, out.msisdn) and (out.has_msisdn = true);
+            else if (name == "content")
+               ok = text(name, empty, content_buf, out.content) and (out.has_content = true);
+            else
+            {
+               out.has_system_id |= name == "system_id";
+               ok = empty or skip_element(name);
+            }
+            if (!ok)
+               return false;
+         }
+
+         return end_tag(root) and skip_misc() and p == end;
+      }
+
+   private:
+      bool starts_with(string_view_t s) const { return size_t(end - p) >= s.size() and memcmp(p, s.data(), s.size()) == 0; }
+
+      static bool is_space(char c) { return c == ' ' or c == '\n' or c == '\r' or c == '\t'; }
+
+      void skip_ws()
+      {
+         while (p < end and is_space(*p))
+            ++p;
+      }
+
+      /// Moves past @close, @return false when it's missing
+      bool skip_past(string_view_t close)
+      {
+         string_view_t rest(p, size_t(end - p));
+         size_t at = rest.find(close);
+         if (at == string_view_t::npos)
+            return false;
+         p += at + close.size();
+         return true;
+      }
+
+      /// Whitespace, comments, processing instructions and the DOCTYPE between elements
+      bool skip_misc()
+      {
+         for (;;)
+         {
+            skip_ws();
+            if (starts_with("<!--"))
+            {
+               if (!skip_past("-->"))
+                  return false;
+            }
+            else if (starts_with("<?"))
+            {
+               if (!skip_past("?>"))
+                  return false;
+            }
+            else if (starts_with("<!DOCTYPE"))
+            {
+               if (!skip_past(">"))   // an internal subset isn't supported
+                  return false;
+            }
+            else
+               return true;
+         }
+      }
+
+      /// <name attr="v" ...> or <name .../>
+      bool start_tag(string_view_t& name, bool& empty)
+      {
+         if (p >= end or *p != '<')
+            return false;
+         const char* b = ++p;
+         while (p < end and !is_space(*p) and *p != '>' and *p != '/')
+            ++p;
+         if (p == b)
+            return false;
+         name = { b, size_t(p - b) };
+
+         for (char quote = 0; p < end; ++p)   // attributes, '>' may be quoted
+         {
+            if (quote)
+            {
+               quote = *p == quote ? 0 : quote;
+               continue;
+            }
+            if (*p == '"' or *p == '\'')
+               quote = *p;
+            else if (*p == '>')
+            {
+               empty = p[-1] == '/';
+               ++p;
+               return true;
+            }
+         }
+         return false;
+      }
+
+      /// </name>
+      bool end_tag(string_view_t name)
+      {
+         if (!starts_with("</"))
+            return false;
+         p += 2;
+         if (!starts_with(name))
+            return false;
+         p += name.size();
+         skip_ws();
+         if (p >= end or *p != '>')
+            return false;
+         ++p;
+         return true;
+      }
+
+      /// The text of the element just opened, up to and including its end tag
+      bool text(string_view_t name, bool empty, std::string& buf, string_view_t& v)
+      {
+         if (empty)
+         {
+            v = {};
+            return true;
+         }
+
+         const char* b = p;
+         auto* lt = static_cast<const char*>(memchr(p, '<', size_t(end - p)));
+         if (!lt)
+            return false;
+         p = lt;
+
+         string_view_t run(b, size_t(lt - b));
+         if (run.find('&') == string_view_t::npos and starts_with("</"))   // plain text, the usual case
+         {
+            v = run;
+            return end_tag(name);
+         }
+
+         buf.clear();   // entities, CDATA or comments: rebuilt in @buf
+         if (!unescape(run, buf))
+            return false;
+         for (;;)
+         {
+            if (starts_with("</"))
+               break;
+            if (starts_with("<![CDATA["))
+            {
+               const char* c = p + 9;
+               if (!skip_past("]]>"))
+                  return false;
+               buf.append(c, size_t(p - 3 - c));
+            }
+            else if (starts_with("<!--"))
+            {
+               if (!skip_past("-->"))
+                  return false;
+            }
+            else
+               return false;   // a child element where text was expected
+
+            b  = p;
+            lt = static_cast<const char*>(memchr(p, '<', size_t(end - p)));
+            if (!lt or !unescape({ b, size_t(lt - b) }, buf))
+               return false;
+            p = lt;
+         }
+         v = buf;
+         return end_tag(name);
+      }
+
+      bool number(string_view_t name, bool empty, uint32_t& v, bool& has)
+      {
+         string_view_t t;
+         if (empty or !text(name, empty, scratch, t))
+            return false;
+
+         size_t b = 0, e = t.size();
+         while (b < e and is_space(t[b]))     ++b;
+         while (e > b and is_space(t[e - 1])) --e;
+         auto r = std::from_chars(t.data() + b, t.data() + e, v);
+         if (r.ec != std::errc() or r.ptr != t.data() + e or b == e)
+            return false;
+         has = true;
+         return true;
+      }
+
+      /// Past the end of the element just opened, whatever it nests
+      bool skip_element(string_view_t name)
+      {
+         for (size_t depth = 1;;)
+         {
+            auto* lt = static_cast<const char*>(memchr(p, '<', size_t(end - p)));
+            if (!lt)
+               return false;
+            p = lt;
+
+            if (starts_with("</"))
+            {
+               if (depth == 1)
+                  return end_tag(name);
+               if (!skip_past(">"))
+                  return false;
+               --depth;
+            }
+            else if (starts_with("<![CDATA["))
+            {
+               if (!skip_past("]]>"))
+                  return false;
+            }
+            else if (starts_with("<!--") or starts_with("<?"))
+            {
+               if (!skip_misc())
+                  return false;
+            }
+            else
+            {
+               string_view_t child;
+               bool          empty;
+               if (!start_tag(child, empty))
+                  return false;
+               depth += !empty;
+            }
+         }
+      }
+
+      /// Appends @in to @out, replacing the predefined entities and character references
+      static bool unescape(string_view_t in, std::string& out)
+      {
+         for (size_t i = 0; i < in.size(); )
+         {
+            size_t amp = in.find('&', i);
+            if (amp == string_view_t::npos)
+            {
+               out.append(in.data() + i, in.size() - i);
+               break;
+            }
+            out.append(in.data() + i, amp - i);
+
+            size_t semi = in.find(';', amp);
+            if (semi == string_view_t::npos)
+               return false;
+            string_view_t ent = in.substr(amp + 1, semi - amp - 1);
+            i = semi + 1;
+
+            if (ent == "amp")       out += '&';
+            else if (ent == "lt")   out += '<';
+            else if (ent == "gt")   out += '>';
+            else if (ent == "quot") out += '"';
+            else if (ent == "apos") out += '\'';
+            else if (ent.size() > 1 and ent[0] == '#')
+            {
+               bool     hex = ent[1] == 'x';
+               uint32_t cp;
+               auto     r   = std::from_chars(ent.data() + 1 + hex, ent.data() + ent.size(), cp, hex ? 16 : 10);
+               if (r.ec != std::errc() or r.ptr != ent.data() + ent.size() or cp > 0x10FFFF or (cp >= 0xD800 and cp < 0xE000))
+                  return false;
+               utf8(cp, out);
+            }
+            else
+               return false;
+         }
+         return true;
+      }
+
+      static void utf8(uint32_t cp, std::string& out)
+      {
+         if (cp < 0x80)
+            out += char(cp);
+         else if (cp < 0x800)
+         {
+            out += char(0xC0 | (cp >> 6));
+            out += char(0x80 | (cp & 0x3F));
+         }
+         else if (cp < 0x10000)
+         {
+            out += char(0xE0 | (cp >> 12));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+         }
+         else
+         {
+            out += char(0xF0 | (cp >> 18));
+            out += char(0x80 | ((cp >> 12) & 0x3F));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+         }
+      }
+
+      const char* p   = nullptr;
+      const char* end = nullptr;
+      std::string msisdn_buf, content_buf, scratch;   ///< rebuilt text, kept between reads
+   };
+}
+
+#endif//xml_reader_h
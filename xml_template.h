@@ -0,0 +1,184 @@
+#ifndef xml_template_h
+#define xml_template_h
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+
+#if defined(__SSE2__)
+   #include <emmintrin.h>
+#endif
+
+#include "codec.h"
+
+//! @brief Request templates for the XML data-transfer-mode
+/** A template is XML text with {field} placeholders for the members of a backend_request_t:
+    @code
+       inline constexpr xml_template_t abort_request { "<abort><sid>{sid}</sid></abort>" };
+    @endcode
+    It's compiled when the program is: the text is cut into segments, each a literal run followed by
+    the field that comes after it, and an unknown {field} or a stray brace fails the build. Rendering
+    reserves the literal bytes plus the strings' sizes once, then appends segment by segment, so
+    there is no format string to parse per request. <br>
+    Strings are escaped for XML text: runs without '&', '<', '>' or control characters are found
+    16 bytes at a time (SSE2) and copied in one go. Control characters XML 1.0 can't carry become
+    U+FFFD.
+*/
+
+namespace gateway
+{
+   enum class xml_field_t : uint8_t { none, command, sid, length, status, msisdn, content, system_id };
+
+   struct xml_template_t
+   {
+      static constexpr size_t max_segments = 16;
+
+      struct segment_t
+      {
+         string_view_t text;
+         xml_field_t   field = xml_field_t::none;   ///< after @text, none for the last segment
+      };
+
+      consteval xml_template_t(const char* src)
+      {
+         string_view_t s(src);
+         size_t at = 0;
+         for (;;)
+         {
+            size_t open = s.find('{', at);
+            if (count == max_segments)
+               throw "xml_template_t: too many fields";
+            if (open == string_view_t::npos)
+            {
+               if (s.substr(at).find('}') != string_view_t::npos)
+                  throw "xml_template_t: stray }";
+               segments[count++] = { s.substr(at), xml_field_t::none };
+               literal_size += s.size() - at;
+               break;
+            }
+
+            size_t close = s.find('}', open);
+            if (close == string_view_t::npos)
+               throw "xml_template_t: unterminated {field}";
+            if (s.substr(at, open - at).find('}') != string_view_t::npos)
+               throw "xml_template_t: stray }";
+
+            segments[count++] = { s.substr(at, open - at), field(s.substr(open + 1, close - open - 1)) };
+            literal_size += open - at;
+            at = close + 1;
+         }
+      }
+
+      /// Appends the request to @out
+      void render(std::string& out, const backend_request_t& req) const
+      {
+         size_t dynamic = 0;
+         for (size_t i = 0; i < count; ++i)
+         {
+            if (segments[i].field == xml_field_t::msisdn)    dynamic += req.msisdn.size();
+            if (segments[i].field == xml_field_t::content)   dynamic += req.content.size();
+            if (segments[i].field == xml_field_t::system_id) dynamic += req.system_id.size();
+         }
+         out.reserve(out.size() + literal_size + dynamic + 11 * count);   // 11: the longest number, "0x%08x"
+
+         for (size_t i = 0; i < count; ++i)
+         {
+            out += segments[i].text;
+            switch (segments[i].field)
+            {
+               case xml_field_t::none:      break;
+               case xml_field_t::command:   number(out, req.command); break;
+               case xml_field_t::sid:       hex(out, req.sid);        break;
+               case xml_field_t::length:    number(out, req.length);  break;
+               case xml_field_t::status:    number(out, req.status);  break;
+               case xml_field_t::msisdn:    escape(out, req.msisdn);    break;
+               case xml_field_t::content:   escape(out, req.content);   break;
+               case xml_field_t::system_id: escape(out, req.system_id); break;
+            }
+         }
+      }
+
+      /// Appends @s as XML text
+      static void escape(std::string& out, string_view_t s)
+      {
+         const char* p   = s.data();
+         const char* end = p + s.size();
+         while (p < end)
+         {
+            const char* run = plain_run(p, end);
+            out.append(p, size_t(run - p));
+            if (run == end)
+               break;
+            switch (*run)
+            {
+               case '&':  out += "&amp;"; break;
+               case '<':  out += "&lt;";  break;
+               case '>':  out += "&gt;";  break;
+               case '\t': case '\n': case '\r': out += *run; break;
+               default:   out += "\xEF\xBF\xBD"; break;   // U+FFFD
+            }
+            p = run + 1;
+         }
+      }
+
+      segment_t segments[max_segments] {};
+      size_t    count        = 0;
+      size_t    literal_size = 0;
+
+   private:
+      static consteval xml_field_t field(string_view_t name)
+      {
+         if (name == "command")   return xml_field_t::command;
+         if (name == "sid")       return xml_field_t::sid;
+         if (name == "length")    return xml_field_t::length;
+         if (name == "status")    return xml_field_t::status;
+         if (name == "msisdn")    return xml_field_t::msisdn;
+         if (name == "content")   return xml_field_t::content;
+         if (name == "system_id") return xml_field_t::system_id;
+         throw "xml_template_t: unknown {field}";
+      }
+
+      static bool needs_escape(char c) { return uint8_t(c) < 0x20 or c == '&' or c == '<' or c == '>'; }
+
+      /// First byte in [@p, @end) that needs escaping, or @end. \t, \n and \r stop the scan too,
+      /// escape() copies them as they are.
+      static const char* plain_run(const char* p, const char* end)
+      {
+      #if defined(__SSE2__)
+         const __m128i amp = _mm_set1_epi8('&'), lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>'), ctl_max = _mm_set1_epi8(0x1F);
+         for (; end - p >= 16; p += 16)
+         {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i ctl  = _mm_cmpeq_epi8(_mm_min_epu8(v, ctl_max), v);   // bytes < 0x20, unsigned
+            __m128i hit  = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                                        _mm_or_si128(_mm_cmpeq_epi8(v, gt), ctl));
+            int     mask = _mm_movemask_epi8(hit);
+            if (mask)
+               return p + __builtin_ctz(unsigned(mask));
+         }
+      #endif
+         while (p < end and !needs_escape(*p))
+            ++p;
+         return p;
+      }
+
+      static void number(std::string& out, uint32_t v)
+      {
+         char tmp[10];
+         auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+         out.append(tmp, size_t(r.ptr - tmp));
+      }
+
+      /// 0x%08x
+      static void hex(std::string& out, uint32_t v)
+      {
+         constexpr char digits[] = "0123456789abcdef";
+         char tmp[10] = { '0', 'x' };
+         for (int i = 0; i < 8; ++i)
+            tmp[2 + i] = digits[(v >> (28 - 4 * i)) & 0xF];
+         out.append(tmp, sizeof(tmp));
+      }
+   };
+}
+
+#endif//xml_template_h